@@ -0,0 +1,747 @@
+#include "csconverter/CSConvertableStruct.h"
+#include "csconverter/CSConvertableFields.h"
+#include "csconverter/CSBatchDecoder.h"
+#include "csconverter/CSColumnarBatch.h"
+#include "csconverter/CSLineSaveParser.h"
+#include "csconverter/CSLineSaveView.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+// Encode/decode throughput and heap allocations per operation for every
+// ValueConverter specialization and a few representative struct shapes.
+//
+//	csbenchmark [--min-time <seconds>] [filter]
+//
+// Only benchmarks whose name contains the filter are run.
+
+// @ ALLOCATION COUNTER @
+
+static std::atomic<std::size_t> allocationsAmount{ 0 };
+
+void* operator new(std::size_t aSize)
+{
+	allocationsAmount.fetch_add(1, std::memory_order_relaxed);
+#if defined(CS_FIELD_STATS)
+	CS::Events::countAllocation();
+#endif
+	if (void* pointer = std::malloc(aSize != 0 ? aSize : 1))
+	{
+		return pointer;
+	}
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t aSize)
+{
+	return operator new(aSize);
+}
+
+// Kept out of line: GCC matches an inlined free() against the operator new
+// call it sees at the call site and reports a mismatch.
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* aPointer) noexcept
+{
+	std::free(aPointer);
+}
+
+// The other forms release through the one above, which pairs with the replaced new.
+void operator delete[](void* aPointer) noexcept
+{
+	operator delete(aPointer);
+}
+
+void operator delete(void* aPointer, std::size_t) noexcept
+{
+	operator delete(aPointer);
+}
+
+void operator delete[](void* aPointer, std::size_t) noexcept
+{
+	operator delete(aPointer);
+}
+
+// @ RUNNER @
+
+struct BenchmarkSettings
+{
+	double minTime = 0.25;
+	std::string filter;
+};
+
+static BenchmarkSettings settings;
+
+// Keeps the compiler from dropping results that are never read.
+template<typename Type>
+void keepValue(const Type& aValue)
+{
+#if defined(_MSC_VER)
+	static const void* volatile sink;
+	sink = &aValue;
+#else
+	// Tells the compiler the value is read, without storing its address anywhere.
+	asm volatile("" : : "g"(&aValue) : "memory");
+#endif
+}
+
+// Runs aOperation in growing batches until settings.minTime has passed and
+// prints records/s, MB/s (of encoded data) and allocations per operation.
+template<typename Operation>
+void runBenchmark(const std::string& aName, std::size_t aRecordsPerOperation, std::size_t aBytesPerOperation, Operation&& aOperation)
+{
+	if (aName.find(settings.filter) == std::string::npos)
+	{
+		return;
+	}
+
+	// Warm up caches and let reused buffers reach their final capacity.
+	aOperation();
+
+	using Clock = std::chrono::steady_clock;
+
+	std::size_t operationsAmount = 0;
+	std::size_t batchSize = 1;
+	double elapsed = 0.0;
+
+	auto allocationsBefore = allocationsAmount.load(std::memory_order_relaxed);
+	auto start = Clock::now();
+
+	while (elapsed < settings.minTime)
+	{
+		for (std::size_t index = 0; index < batchSize; ++index)
+		{
+			aOperation();
+		}
+
+		operationsAmount += batchSize;
+		batchSize *= 2;
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	auto allocations = allocationsAmount.load(std::memory_order_relaxed) - allocationsBefore;
+
+	auto operationsPerSecond = operationsAmount / elapsed;
+	auto recordsPerSecond = operationsPerSecond * aRecordsPerOperation;
+	auto megabytesPerSecond = operationsPerSecond * aBytesPerOperation / (1024.0 * 1024.0);
+	auto allocationsPerOperation = static_cast<double>(allocations) / operationsAmount;
+
+	std::cout << std::left << std::setw(40) << aName << std::right
+		<< std::setw(16) << std::fixed << std::setprecision(0) << recordsPerSecond
+		<< std::setw(12) << std::setprecision(1) << megabytesPerSecond
+		<< std::setw(14) << std::setprecision(2) << allocationsPerOperation << "\n";
+}
+
+void printHeader(std::string_view aSection)
+{
+	std::cout << "\n-- " << aSection << " --\n\n";
+	std::cout << std::left << std::setw(40) << "benchmark" << std::right
+		<< std::setw(16) << "records/s"
+		<< std::setw(12) << "MB/s"
+		<< std::setw(14) << "allocs/op" << "\n";
+}
+
+// @ VALUE CONVERTERS @
+
+enum class BenchmarkEnum : std::int32_t
+{
+	First,
+	Second,
+	Last = 1024
+};
+
+template<typename Type>
+void benchmarkConverter(const std::string& aName, const Type& aValue)
+{
+	ValueConverter<Type> converter;
+
+	// Decode benchmarks read these even when the encode ones are filtered out.
+	auto text = converter.toTyped(aValue);
+	runBenchmark(aName + " text encode", 1, converter.typedSize(aValue), [&]()
+	{
+		text.clear();
+		converter.appendTyped(text, aValue);
+	});
+
+	Type decoded{};
+	runBenchmark(aName + " text decode", 1, text.size(), [&]()
+	{
+		decoded = converter.castTyped(text);
+		keepValue(decoded);
+	});
+
+	std::string binary;
+	converter.appendBinary(binary, aValue);
+	runBenchmark(aName + " binary encode", 1, converter.binarySize(aValue), [&]()
+	{
+		binary.clear();
+		converter.appendBinary(binary, aValue);
+	});
+
+	runBenchmark(aName + " binary decode", 1, binary.size(), [&]()
+	{
+		std::string_view view = binary;
+		decoded = converter.castBinary(view);
+		keepValue(decoded);
+	});
+}
+
+void benchmarkConverters()
+{
+	printHeader("Value converters");
+
+	benchmarkConverter<std::string>("string", "a line save value of about forty chars");
+	benchmarkConverter<std::int64_t>("integral", -1234567890123);
+	benchmarkConverter<double>("floating", 3.141592653589793);
+	benchmarkConverter<bool>("bool", true);
+	benchmarkConverter<BenchmarkEnum>("enum", BenchmarkEnum::Last);
+
+	std::vector<int> vector;
+	for (int index = 0; index < 64; ++index)
+	{
+		vector.push_back(index * 977);
+	}
+
+	benchmarkConverter("vector<int>[64]", vector);
+
+	std::vector<double> numbers;
+	for (int index = 0; index < 64; ++index)
+	{
+		numbers.push_back(index * 0.731 - 20.5);
+	}
+
+	benchmarkConverter("vector<double>[64]", numbers);
+
+	std::array<float, 16> array{};
+	for (std::size_t index = 0; index < array.size(); ++index)
+	{
+		array[index] = static_cast<float>(index) * 1.25f;
+	}
+
+	benchmarkConverter("array<float,16>", array);
+	benchmarkConverter<std::pair<std::string, int>>("pair<string,int>", { "pair_key", 4096 });
+
+	std::map<std::string, int> map;
+	for (int index = 0; index < 64; ++index)
+	{
+		map.emplace("key_" + std::to_string(index), index * 31);
+	}
+
+	benchmarkConverter("map<string,int>[64]", map);
+}
+
+// @ STRUCT SHAPES @
+
+// Same shape as the StructTest record of the demo.
+struct SmallStruct : public ConvertableStruct
+{
+	int value = 10;
+	std::string type = "work";
+	std::map<std::string, int> testMap = { { "test1", 200 }, { "test2", 300 }, { "test6", 500 }, { "test7", 800 } };
+	std::vector<std::string> testVector = { "ar_test", "ar_test2", "ar_tes3", "ar_tes4" };
+
+	SmallStruct()
+	{
+		pushValue("value", &value);
+		pushValue("type", &type);
+		pushValue("testMap", &testMap);
+		pushValue("testVector", &testVector);
+	}
+};
+
+struct StaticSmallStruct
+{
+	int value = 10;
+	std::string type = "work";
+	std::map<std::string, int> testMap = { { "test1", 200 }, { "test2", 300 }, { "test6", 500 }, { "test7", 800 } };
+	std::vector<std::string> testVector = { "ar_test", "ar_test2", "ar_tes3", "ar_tes4" };
+};
+
+// SmallStruct with std::pmr fields, built on the memory resource of a batch.
+struct PmrSmallStruct : public ConvertableStruct
+{
+	int value = 10;
+	std::pmr::string type;
+	std::pmr::map<std::pmr::string, int> testMap;
+	std::pmr::vector<std::pmr::string> testVector;
+
+	explicit PmrSmallStruct(std::pmr::memory_resource* aResource = std::pmr::get_default_resource())
+		: type{ aResource }, testMap{ aResource }, testVector{ aResource }
+	{
+		pushValue("value", &value);
+		pushValue("type", &type);
+		pushValue("testMap", &testMap);
+		pushValue("testVector", &testVector);
+	}
+};
+
+CS_CONVERTABLE_FIELDS(StaticSmallStruct, CS_FIELD(value), CS_FIELD(type), CS_FIELD(testMap), CS_FIELD(testVector))
+
+// Many scalar fields and no containers.
+struct WideStruct : public ConvertableStruct
+{
+	static constexpr int IntegralsAmount = 32;
+	static constexpr int FloatingsAmount = 16;
+	static constexpr int StringsAmount = 16;
+
+	std::int64_t integrals[IntegralsAmount];
+	double floatings[FloatingsAmount];
+	std::string strings[StringsAmount];
+
+	WideStruct()
+	{
+		for (int index = 0; index < IntegralsAmount; ++index)
+		{
+			integrals[index] = index * 1000003LL;
+			pushValue(fieldKey("integral", index), &integrals[index]);
+		}
+
+		for (int index = 0; index < FloatingsAmount; ++index)
+		{
+			floatings[index] = index / 7.0;
+			pushValue(fieldKey("floating", index), &floatings[index]);
+		}
+
+		for (int index = 0; index < StringsAmount; ++index)
+		{
+			strings[index] = "string_value_" + std::to_string(index);
+			pushValue(fieldKey("string", index), &strings[index]);
+		}
+	}
+
+private:
+	static std::string fieldKey(std::string_view aPrefix, int aIndex)
+	{
+		return std::string(aPrefix) + std::to_string(aIndex);
+	}
+};
+
+// Few fields, each holding a large container.
+struct HugeStruct : public ConvertableStruct
+{
+	static constexpr int ElementsAmount = 10000;
+
+	std::map<std::string, int> map;
+	std::vector<std::string> vector;
+	std::vector<double> numbers;
+
+	HugeStruct()
+	{
+		pushValue("map", &map);
+		pushValue("vector", &vector);
+		pushValue("numbers", &numbers);
+	}
+
+	void fill()
+	{
+		for (int index = 0; index < ElementsAmount; ++index)
+		{
+			map.emplace("map_key_" + std::to_string(index), index);
+			vector.push_back("vector_value_" + std::to_string(index));
+			numbers.push_back(index * 0.5);
+		}
+	}
+};
+
+const char* wireFormatName(CSTypeDefines::WireFormat aFormat)
+{
+	switch (aFormat)
+	{
+	case CSTypeDefines::WireFormat::Binary:
+		return " binary";
+	case CSTypeDefines::WireFormat::Framed:
+		return " framed";
+	default:
+		return " text";
+	}
+}
+
+template<typename StructType>
+void benchmarkStruct(const std::string& aName, StructType& aObject, CSTypeDefines::WireFormat aFormat)
+{
+	auto formatName = wireFormatName(aFormat);
+
+	auto encoded = aObject.convertObjectToLineSave(aFormat);
+	runBenchmark(aName + formatName + " encode", 1, aObject.encodedSize(aFormat), [&]()
+	{
+		encoded.clear();
+		aObject.convertObjectToLineSave(encoded, aFormat);
+	});
+
+	StructType decoded;
+	runBenchmark(aName + formatName + " decode", 1, encoded.size(), [&]()
+	{
+		decoded.convertLineSaveToObject(encoded, aFormat);
+		keepValue(decoded);
+	});
+
+	runBenchmark(aName + formatName + " try decode", 1, encoded.size(), [&]()
+	{
+		keepValue(decoded.tryConvertLineSaveToObject(encoded, aFormat));
+		keepValue(decoded);
+	});
+
+	// Binary has no type headers to skip.
+	if (aFormat != CSTypeDefines::WireFormat::Binary)
+	{
+		auto fingerprint = aObject.fingerprint();
+		runBenchmark(aName + formatName + " decode fingerprinted", 1, encoded.size(), [&]()
+		{
+			decoded.convertLineSaveToObject(encoded, fingerprint, aFormat);
+			keepValue(decoded);
+		});
+	}
+}
+
+// Decodes only aKeys out of the encoded object.
+template<typename StructType>
+void benchmarkProjection(const std::string& aName, StructType& aObject, std::initializer_list<std::string_view> aKeys, CSTypeDefines::WireFormat aFormat)
+{
+	auto formatName = wireFormatName(aFormat);
+
+	auto encoded = aObject.convertObjectToLineSave(aFormat);
+
+	StructType decoded;
+	auto selection = decoded.selectFields(aKeys);
+	runBenchmark(aName + formatName + " decode " + std::to_string(aKeys.size()) + " field(s)", 1, encoded.size(), [&]()
+	{
+		decoded.convertLineSaveToObject(encoded, selection, aFormat);
+		keepValue(decoded);
+	});
+}
+
+template<typename StructType>
+void benchmarkStaticStruct(const std::string& aName, const StructType& aObject, CSTypeDefines::WireFormat aFormat)
+{
+	using Static = StaticConvertableStruct<StructType>;
+
+	auto formatName = wireFormatName(aFormat);
+
+	auto encoded = Static::convertObjectToLineSave(aObject, aFormat);
+	runBenchmark(aName + formatName + " encode", 1, Static::encodedSize(aObject, aFormat), [&]()
+	{
+		encoded.clear();
+		Static::convertObjectToLineSave(aObject, encoded, aFormat);
+	});
+
+	StructType decoded;
+	runBenchmark(aName + formatName + " decode", 1, encoded.size(), [&]()
+	{
+		Static::convertLineSaveToObject(encoded, decoded, aFormat);
+		keepValue(decoded);
+	});
+}
+
+void benchmarkStructs()
+{
+	printHeader("Struct shapes");
+
+	SmallStruct small;
+	StaticSmallStruct staticSmall;
+	WideStruct wide;
+	HugeStruct huge;
+	huge.fill();
+
+	for (auto format : { CSTypeDefines::WireFormat::Text, CSTypeDefines::WireFormat::Binary, CSTypeDefines::WireFormat::Framed })
+	{
+		benchmarkStruct("small", small, format);
+		benchmarkStaticStruct("small static", staticSmall, format);
+		benchmarkStruct("wide[64]", wide, format);
+		benchmarkStruct("huge[3x10000]", huge, format);
+	}
+
+	for (auto format : { CSTypeDefines::WireFormat::Text, CSTypeDefines::WireFormat::Binary, CSTypeDefines::WireFormat::Framed })
+	{
+		benchmarkProjection("small", small, { "value" }, format);
+		benchmarkProjection("wide[64]", wide, { "integral7", "string3" }, format);
+		benchmarkProjection("huge[3x10000]", huge, { "numbers" }, format);
+	}
+
+	// Every instance pushes its fields again, against the shared schema.
+	runBenchmark("small construct", 1, 0, []() { SmallStruct object; keepValue(object); });
+	runBenchmark("wide[64] construct", 1, 0, []() { WideStruct object; keepValue(object); });
+}
+
+// Peeking at records through LineSaveView instead of decoding them.
+void benchmarkViews()
+{
+	printHeader("Line save views");
+
+	SmallStruct small;
+	auto smallLine = small.convertObjectToLineSave();
+
+	LineSaveView view(smallLine, small.getSchema());
+	runBenchmark("small view get 1 field", 1, smallLine.size(), [&]()
+	{
+		view.assign(smallLine);
+		auto value = view.get<int>("value");
+		keepValue(value);
+	});
+
+	HugeStruct huge;
+	huge.fill();
+	auto hugeLine = huge.convertObjectToLineSave();
+
+	StructuralIndex index;
+	runBenchmark("huge[3x10000] structural index", 1, hugeLine.size(), [&]()
+	{
+		index.build(hugeLine);
+		keepValue(index);
+	});
+
+	LineSaveView hugeView(hugeLine, huge.getSchema());
+	runBenchmark("huge[3x10000] view sum numbers", 1, hugeLine.size(), [&]()
+	{
+		hugeView.assign(hugeLine);
+
+		double sum = 0.0;
+		for (auto number : hugeView.elements<double>("numbers"))
+		{
+			sum += number;
+		}
+
+		keepValue(sum);
+	});
+
+	runBenchmark("huge[3x10000] view sum map values", 1, hugeLine.size(), [&]()
+	{
+		hugeView.assign(hugeLine);
+
+		long long sum = 0;
+		for (auto [key, value] : hugeView.entries<std::string_view, int>("map"))
+		{
+			sum += value;
+		}
+
+		keepValue(sum);
+	});
+}
+
+// One changed field and one changed map entry against the full line save.
+void benchmarkDeltas()
+{
+	printHeader("Deltas");
+
+	HugeStruct previous;
+	previous.fill();
+
+	HugeStruct updated = previous;
+	updated.map["map_key_5000"] = -1;
+	updated.vector.push_back("appended_value");
+
+	for (auto format : { CSTypeDefines::WireFormat::Text, CSTypeDefines::WireFormat::Binary, CSTypeDefines::WireFormat::Framed })
+	{
+		auto formatName = std::string(wireFormatName(format));
+
+		auto delta = updated.convertObjectToDelta(previous, format);
+		runBenchmark("huge[3x10000] 2 changes" + formatName + " delta", 1, delta.size(), [&]()
+		{
+			delta.clear();
+			updated.convertObjectToDelta(previous, delta, format);
+		});
+
+		HugeStruct applied = previous;
+		runBenchmark("huge[3x10000] 2 changes" + formatName + " apply", 1, delta.size(), [&]()
+		{
+			applied.applyDelta(delta, format);
+			applied.vector.pop_back();
+		});
+	}
+}
+
+// @ RECORD STREAMS @
+
+void benchmarkBatches()
+{
+	printHeader("Record batches");
+
+	constexpr std::size_t RecordsAmount = 10000;
+
+	SmallStruct small;
+	std::string data;
+	for (std::size_t index = 0; index < RecordsAmount; ++index)
+	{
+		small.value = static_cast<int>(index);
+		small.convertObjectToLineSave(data);
+		data += CSTypeDefines::csRecordDelimiter;
+	}
+
+	std::vector<SmallStruct> records;
+	runBenchmark("small batch decode (1 thread)", RecordsAmount, data.size(), [&]()
+	{
+		BatchDecoder<SmallStruct>::decode(data, records, 1);
+		keepValue(records);
+	});
+
+	runBenchmark("small batch decode (all threads)", RecordsAmount, data.size(), [&]()
+	{
+		BatchDecoder<SmallStruct>::decode(data, records);
+		keepValue(records);
+	});
+
+	// The arena refills from one reused buffer, so a whole batch is freed by
+	// two release() calls instead of a delete per string and node.
+	std::vector<char> batchBuffer(data.size() * 8);
+	std::pmr::monotonic_buffer_resource batchMemory(batchBuffer.data(), batchBuffer.size());
+	BatchArena arena(&batchMemory);
+	std::vector<PmrSmallStruct> pmrRecords;
+
+	auto decodePmr = [&](std::size_t aThreadsAmount)
+	{
+		pmrRecords.clear();
+		arena.release();
+		batchMemory.release();
+
+		BatchDecoder<PmrSmallStruct>::decode(data, pmrRecords, arena, aThreadsAmount);
+		keepValue(pmrRecords);
+	};
+
+	runBenchmark("small pmr batch decode (1 thread)", RecordsAmount, data.size(), [&]() { decodePmr(1); });
+	runBenchmark("small pmr batch decode (all threads)", RecordsAmount, data.size(), [&]() { decodePmr(0); });
+
+	// Pushed in socket-sized chunks that cut records anywhere.
+	SmallStruct parsed;
+	LineSaveParser parser(parsed);
+	for (std::size_t chunkSize : { std::size_t(64), std::size_t(1500) })
+	{
+		runBenchmark("small parser feed (" + std::to_string(chunkSize) + " byte chunks)", RecordsAmount, data.size(), [&]()
+		{
+			std::string_view input = data;
+			while (!input.empty())
+			{
+				auto chunk = input.substr(0, chunkSize);
+				input.remove_prefix(chunk.size());
+				parser.feed(chunk, [](ConvertableStruct& aRecord) { keepValue(aRecord); });
+			}
+		});
+	}
+
+	// Sizes are of the columnar data, compare them to the line save batch above.
+	std::vector<SmallStruct> columnRecords(RecordsAmount);
+	for (std::size_t index = 0; index < RecordsAmount; ++index)
+	{
+		columnRecords[index].value = static_cast<int>(index);
+	}
+
+	for (auto [name, format] : { std::pair{ "text", CSTypeDefines::WireFormat::Text }, std::pair{ "binary", CSTypeDefines::WireFormat::Binary } })
+	{
+		std::string columns;
+		ColumnarBatch<SmallStruct>::encode(columnRecords, columns, format);
+
+		runBenchmark(std::string("small columnar encode (") + name + ")", RecordsAmount, columns.size(), [&]()
+		{
+			columns.clear();
+			ColumnarBatch<SmallStruct>::encode(columnRecords, columns, format);
+			keepValue(columns);
+		});
+
+		runBenchmark(std::string("small columnar decode (") + name + ")", RecordsAmount, columns.size(), [&]()
+		{
+			ColumnarBatch<SmallStruct>::decode(columns, records, format);
+			keepValue(records);
+		});
+
+		runBenchmark(std::string("small columnar decode one column (") + name + ")", RecordsAmount, columns.size(), [&]()
+		{
+			ColumnarBatch<SmallStruct>::decodeColumn(columns, "value", records, format);
+			keepValue(records);
+		});
+	}
+}
+
+// Edge ingest input where every second record is broken, half of them in a
+// number and half in a map.
+void benchmarkMalformed()
+{
+	printHeader("Malformed records");
+
+	constexpr std::size_t RecordsAmount = 10000;
+
+	SmallStruct small;
+	std::vector<std::string> lines;
+	std::size_t dataSize = 0;
+	for (std::size_t index = 0; index < RecordsAmount; ++index)
+	{
+		auto line = small.convertObjectToLineSave();
+		if (index % 4 == 1)
+		{
+			line.replace(line.rfind("i$10"), 4, "i$1x");
+		}
+		else if (index % 4 == 3)
+		{
+			line.replace(line.find("m$s^i$4$"), 8, "m$s^i$5$");
+		}
+
+		dataSize += line.size() + CSTypeDefines::csRecordDelimiter.size();
+		lines.push_back(std::move(line));
+	}
+
+	SmallStruct decoded;
+	runBenchmark("small 50% malformed decode (throwing)", RecordsAmount, dataSize, [&]()
+	{
+		std::size_t failed = 0;
+		for (auto& line : lines)
+		{
+			try
+			{
+				decoded.convertLineSaveToObject(line);
+			}
+			catch (const std::exception&)
+			{
+				++failed;
+			}
+		}
+
+		keepValue(failed);
+	});
+
+	runBenchmark("small 50% malformed try decode", RecordsAmount, dataSize, [&]()
+	{
+		std::size_t failed = 0;
+		for (auto& line : lines)
+		{
+			if (!decoded.tryConvertLineSaveToObject(line))
+			{
+				++failed;
+			}
+		}
+
+		keepValue(failed);
+	});
+}
+
+int main(int argc, char** argv)
+{
+	for (int index = 1; index < argc; ++index)
+	{
+		std::string_view argument = argv[index];
+		if (argument == "--min-time" && index + 1 < argc)
+		{
+			settings.minTime = std::atof(argv[++index]);
+		}
+		else
+		{
+			settings.filter = argument;
+		}
+	}
+
+	benchmarkConverters();
+	benchmarkStructs();
+	benchmarkViews();
+	benchmarkDeltas();
+	benchmarkBatches();
+	benchmarkMalformed();
+
+#if defined(CS_FIELD_STATS)
+	// Counters of every run above, including the warm up ones.
+	std::cout << "\n-- SmallStruct field stats --\n\n" << SmallStruct().fieldStats().text();
+#endif
+
+	return 0;
+}
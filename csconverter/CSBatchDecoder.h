@@ -0,0 +1,331 @@
+#ifndef __CS_BATCH_DECODER_H__
+#define __CS_BATCH_DECODER_H__
+
+#include "CSConvertableStruct.h"
+
+#include <atomic>
+#include <exception>
+#include <memory_resource>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+struct BatchDecodeError
+{
+	// Position of the record among the non-empty records of the input.
+	std::size_t recordIndex;
+	std::string message;
+};
+
+struct BatchDecodeResult
+{
+	std::size_t recordsAmount = 0;
+	std::vector<BatchDecodeError> errors;
+
+	bool succeeded() const { return errors.empty(); }
+};
+
+// Memory for records decoded by BatchDecoder into std::pmr fields. Every
+// chunk of the input gets its own monotonic buffer, so workers never share
+// an allocator, and all of it is freed at once by release() or the
+// destructor. The buffers refill from aUpstream, e.g. a caller's
+// std::pmr::monotonic_buffer_resource; those rare calls are serialized.
+// Records must be cleared or destroyed before the arena is released.
+struct BatchArena
+{
+public:
+	explicit BatchArena(std::pmr::memory_resource* aUpstream = std::pmr::get_default_resource())
+		: upstream{ aUpstream } {}
+
+	BatchArena(const BatchArena&) = delete;
+	BatchArena& operator=(const BatchArena&) = delete;
+
+	void release() { buffers.clear(); }
+
+	// A new buffer for the records of one chunk.
+	std::pmr::memory_resource* acquire()
+	{
+		buffers.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>(&upstream));
+		return buffers.back().get();
+	}
+
+private:
+	struct LockedResource : public std::pmr::memory_resource
+	{
+		explicit LockedResource(std::pmr::memory_resource* aResource) : resource{ aResource } {}
+
+		std::pmr::memory_resource* resource;
+		std::mutex mutex;
+
+		void* do_allocate(std::size_t aBytes, std::size_t aAlignment) override
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return resource->allocate(aBytes, aAlignment);
+		}
+
+		void do_deallocate(void* aPointer, std::size_t aBytes, std::size_t aAlignment) override
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			resource->deallocate(aPointer, aBytes, aAlignment);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& aOther) const noexcept override { return this == &aOther; }
+	};
+
+	LockedResource upstream;
+	std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> buffers;
+};
+
+// Decodes a buffer (or mapped file) of newline delimited line saves on
+// several threads. The input is cut at record boundaries into many more
+// chunks than threads and idle workers keep pulling the next chunk from a
+// shared counter, so a slow chunk does not hold the others back. The worker
+// of a chunk constructs and decodes its records, which are then moved into
+// the destination in input order; a record that fails to decode is reported
+// with its index and the rest of its chunk still decodes.
+// A fingerprint header on the first line (LineSaveWriter::writeFingerprint)
+// applies to every record, see ConvertableStruct::convertLineSaveToObject.
+template<typename StructType>
+struct BatchDecoder
+{
+public:
+	static BatchDecodeResult decode(std::string_view aData, std::vector<StructType>& aRecords, std::size_t aThreadsAmount = 0)
+	{
+		return decodeChunks(aData, aRecords, aThreadsAmount, nullptr, [](std::vector<StructType>& aChunkRecords, std::pmr::memory_resource*)
+		{
+			aChunkRecords.emplace_back();
+		});
+	}
+
+	// Same, with the records allocating from aArena: StructType is built from
+	// the std::pmr::memory_resource* of its chunk and passes it on to its
+	// std::pmr fields.
+	static BatchDecodeResult decode(std::string_view aData, std::vector<StructType>& aRecords, BatchArena& aArena, std::size_t aThreadsAmount = 0)
+	{
+		static_assert(std::is_constructible_v<StructType, std::pmr::memory_resource*>, "StructType needs a std::pmr::memory_resource* constructor");
+
+		return decodeChunks(aData, aRecords, aThreadsAmount, &aArena, [](std::vector<StructType>& aChunkRecords, std::pmr::memory_resource* aResource)
+		{
+			aChunkRecords.emplace_back(aResource);
+		});
+	}
+
+private:
+	static constexpr std::size_t ChunksPerThread = 8;
+
+	struct Chunk
+	{
+		std::string_view data;
+		std::pmr::memory_resource* resource = nullptr;
+		std::vector<StructType> records;
+		// Record indexes are counted from the start of the chunk.
+		std::vector<BatchDecodeError> errors;
+	};
+
+	template<typename MakeRecord>
+	static BatchDecodeResult decodeChunks(std::string_view aData, std::vector<StructType>& aRecords, std::size_t aThreadsAmount, BatchArena* aArena, MakeRecord&& aMakeRecord)
+	{
+		BatchDecodeResult result;
+
+		std::uint64_t fingerprint = 0;
+		bool hasFingerprint = readHeader(aData, fingerprint);
+
+		auto threadsAmount = aThreadsAmount != 0 ? aThreadsAmount : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		auto chunks = splitChunks(aData, threadsAmount == 1 ? 1 : threadsAmount * ChunksPerThread);
+
+		if (aArena)
+		{
+			for (auto& chunk : chunks)
+			{
+				chunk.resource = aArena->acquire();
+			}
+		}
+
+		// The first chunk decodes into the storage of aRecords, which spares
+		// moving its records and is all of them on a single thread.
+		aRecords.clear();
+		if (!chunks.empty())
+		{
+			chunks.front().records.swap(aRecords);
+		}
+
+		runParallel(threadsAmount, chunks.size(), [&chunks, &aMakeRecord, fingerprint, hasFingerprint](std::size_t aChunkIndex)
+		{
+			auto& chunk = chunks[aChunkIndex];
+			chunk.records.reserve(forEachRecord(chunk.data, [](std::string_view) {}));
+
+			forEachRecord(chunk.data, [&chunk, &aMakeRecord, fingerprint, hasFingerprint](std::string_view aLine)
+			{
+				aMakeRecord(chunk.records, chunk.resource);
+
+				try
+				{
+					if (hasFingerprint)
+					{
+						chunk.records.back().convertLineSaveToObject(aLine, fingerprint);
+					}
+					else
+					{
+						chunk.records.back().convertLineSaveToObject(aLine);
+					}
+				}
+				catch (const std::exception& aError)
+				{
+					chunk.errors.push_back({ chunk.records.size() - 1, aError.what() });
+				}
+			});
+		});
+
+		for (auto& chunk : chunks)
+		{
+			result.recordsAmount += chunk.records.size();
+		}
+
+		if (!chunks.empty())
+		{
+			aRecords.swap(chunks.front().records);
+		}
+
+		aRecords.reserve(result.recordsAmount);
+		for (auto& chunk : chunks)
+		{
+			auto firstRecord = &chunk == &chunks.front() ? 0 : aRecords.size();
+			for (auto& error : chunk.errors)
+			{
+				error.recordIndex += firstRecord;
+				result.errors.push_back(std::move(error));
+			}
+
+			if (&chunk != &chunks.front())
+			{
+				aRecords.insert(aRecords.end(), std::make_move_iterator(chunk.records.begin()), std::make_move_iterator(chunk.records.end()));
+			}
+		}
+
+		return result;
+	}
+
+	// Takes a leading fingerprint header off aData.
+	static bool readHeader(std::string_view& aData, std::uint64_t& aFingerprint)
+	{
+		auto lineEnd = aData.find(CSTypeDefines::csRecordDelimiter);
+		auto line = aData.substr(0, lineEnd);
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.remove_suffix(1);
+		}
+
+		if (!CS::DataHelper::readFingerprintHeader(line, aFingerprint))
+		{
+			return false;
+		}
+
+		aData.remove_prefix(lineEnd == std::string_view::npos ? aData.size() : lineEnd + CSTypeDefines::csRecordDelimiter.size());
+		return true;
+	}
+
+	static std::vector<Chunk> splitChunks(std::string_view aData, std::size_t aChunksAmount)
+	{
+		std::vector<Chunk> chunks;
+
+		auto chunkSize = std::max<std::size_t>(1, aData.size() / std::max<std::size_t>(1, aChunksAmount));
+		while (!aData.empty())
+		{
+			auto chunkEnd = chunkSize < aData.size() ? aData.find(CSTypeDefines::csRecordDelimiter, chunkSize) : std::string_view::npos;
+			if (chunkEnd == std::string_view::npos)
+			{
+				chunks.push_back({ aData, nullptr, {}, {} });
+				break;
+			}
+
+			chunkEnd += CSTypeDefines::csRecordDelimiter.size();
+			chunks.push_back({ aData.substr(0, chunkEnd), nullptr, {}, {} });
+			aData.remove_prefix(chunkEnd);
+		}
+
+		return chunks;
+	}
+
+	template<typename Callback>
+	static std::size_t forEachRecord(std::string_view aData, Callback&& aCallback)
+	{
+		std::size_t recordsAmount = 0;
+		for (auto line : CS::DataHelper::split(aData, CSTypeDefines::csRecordDelimiter))
+		{
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.remove_suffix(1);
+			}
+
+			if (!line.empty())
+			{
+				aCallback(line);
+				++recordsAmount;
+			}
+		}
+
+		return recordsAmount;
+	}
+
+	// A task that throws stops the handing out of further tasks, its
+	// exception is rethrown once every worker has been joined.
+	template<typename Task>
+	static void runParallel(std::size_t aThreadsAmount, std::size_t aTasksAmount, Task&& aTask)
+	{
+		std::atomic<std::size_t> nextTask{ 0 };
+		std::exception_ptr error;
+		std::mutex errorMutex;
+
+		auto worker = [&nextTask, &error, &errorMutex, &aTask, aTasksAmount]()
+		{
+			try
+			{
+				for (auto taskIndex = nextTask++; taskIndex < aTasksAmount; taskIndex = nextTask++)
+				{
+					aTask(taskIndex);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error)
+				{
+					error = std::current_exception();
+				}
+
+				nextTask = aTasksAmount;
+			}
+		};
+
+		auto threadsAmount = std::min(aThreadsAmount, aTasksAmount);
+		std::vector<std::thread> threads;
+		threads.reserve(threadsAmount);
+
+		for (std::size_t index = 1; index < threadsAmount; ++index)
+		{
+			try
+			{
+				threads.emplace_back(worker);
+			}
+			catch (const std::system_error&)
+			{
+				// Out of threads, the ones already running share the work.
+				break;
+			}
+		}
+
+		worker();
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+};
+
+#endif // !__CS_BATCH_DECODER_H__
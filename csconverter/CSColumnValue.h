@@ -0,0 +1,198 @@
+#ifndef __CS_COLUMN_VALUE_H__
+#define __CS_COLUMN_VALUE_H__
+
+#include "CSValueConverter.h"
+#include "CSFramedValue.h"
+
+// One field of every record of a ColumnarBatch. The type header is written
+// once and the values of the records follow it:
+//
+//	text:   i$10|11|12 or v$s$2$a^b|0$|1$c, the typed text of every value without its header
+//	framed: i$8:2:102:112:12, the frames of the values in one frame
+//	binary: the binary values, integers as zigzag varint deltas from the previous record
+//
+// aValueAt(index) returns the field of the record at index.
+template<typename Type>
+struct ColumnValue
+{
+	template<typename ValueAt>
+	static void append(std::string& aBuffer, std::size_t aAmount, ValueAt&& aValueAt, CSTypeDefines::WireFormat aFormat)
+	{
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			appendBinary(aBuffer, aAmount, aValueAt);
+			return;
+		}
+
+		aBuffer += ValueConverter<Type>::signature();
+
+		if (aFormat == CSTypeDefines::WireFormat::Framed)
+		{
+			auto payloadStart = aBuffer.size();
+			for (std::size_t index = 0; index < aAmount; ++index)
+			{
+				FramedValue<Type>::append(aBuffer, aValueAt(index));
+			}
+
+			CS::FramingHelper::insertFrameLength(aBuffer, payloadStart);
+			return;
+		}
+
+		ValueConverter<Type> converter;
+		for (std::size_t index = 0; index < aAmount; ++index)
+		{
+			if (index != 0)
+			{
+				aBuffer += CSTypeDefines::csValueDelimiter;
+			}
+
+			auto& value = aValueAt(index);
+			if constexpr (IsContainer)
+			{
+				CS::TypeHelper::appendContainerCount(aBuffer, std::size(value));
+			}
+
+			converter.appendString(aBuffer, value);
+		}
+	}
+
+	// aColumn has to hold exactly aAmount values.
+	template<typename ValueAt>
+	static void castInto(std::string_view aColumn, std::size_t aAmount, ValueAt&& aValueAt, CSTypeDefines::WireFormat aFormat)
+	{
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			castBinaryInto(aColumn, aAmount, aValueAt);
+		}
+		else if (aFormat == CSTypeDefines::WireFormat::Framed)
+		{
+			aColumn = CS::TypeHelper::stripSignature(aColumn, ValueConverter<Type>::signature());
+			auto payload = CS::FramingHelper::readFrame(aColumn);
+			for (std::size_t index = 0; index < aAmount; ++index)
+			{
+				FramedValue<Type>::castInto(payload, aValueAt(index));
+			}
+
+			if (!payload.empty())
+			{
+				CS::Errors::throwExceptionMalformedColumn("values amount");
+			}
+		}
+		else
+		{
+			castStringInto(CS::TypeHelper::stripSignature(aColumn, ValueConverter<Type>::signature()), aAmount, aValueAt);
+			return;
+		}
+
+		if (!aColumn.empty())
+		{
+			CS::Errors::throwExceptionMalformedColumn("column end");
+		}
+	}
+
+private:
+	static constexpr bool IsContainer = CS::TypeHelper::IsVector<Type>::value || CS::TypeHelper::IsArray<Type>::value || CS::TypeHelper::IsMap<Type>::value;
+	static constexpr bool IsDeltaNumber = std::is_integral_v<Type> && !std::is_same_v<Type, bool>;
+
+	template<typename ValueAt>
+	static void castStringInto(std::string_view aValues, std::size_t aAmount, ValueAt& aValueAt)
+	{
+		ValueConverter<Type> converter;
+
+		std::size_t index = 0;
+		if (aAmount != 0)
+		{
+			for (auto value : CS::DataHelper::split(aValues, CSTypeDefines::csValueDelimiter))
+			{
+				if (index == aAmount)
+				{
+					CS::Errors::throwExceptionMalformedColumn("values amount");
+				}
+
+				if constexpr (IsContainer)
+				{
+					converter.castCountedInto(value, aValueAt(index++));
+				}
+				else
+				{
+					converter.castInto(value, aValueAt(index++));
+				}
+			}
+		}
+
+		if (index != aAmount || (aAmount == 0 && !aValues.empty()))
+		{
+			CS::Errors::throwExceptionMalformedColumn("values amount");
+		}
+	}
+
+	template<typename ValueAt>
+	static void appendBinary(std::string& aBuffer, std::size_t aAmount, ValueAt& aValueAt)
+	{
+		if constexpr (IsDeltaNumber)
+		{
+			// Sorted or slowly changing columns (ids, timestamps) shrink to
+			// one or two bytes a value.
+			std::uint64_t previous = 0;
+			for (std::size_t index = 0; index < aAmount; ++index)
+			{
+				auto value = static_cast<std::uint64_t>(aValueAt(index));
+				CS::BinaryHelper::appendVarint(aBuffer, CS::BinaryHelper::zigZagEncode(static_cast<std::int64_t>(value - previous)));
+				previous = value;
+			}
+		}
+		else
+		{
+			ValueConverter<Type> converter;
+			for (std::size_t index = 0; index < aAmount; ++index)
+			{
+				converter.appendBinary(aBuffer, aValueAt(index));
+			}
+		}
+	}
+
+	template<typename ValueAt>
+	static void castBinaryInto(std::string_view& aColumn, std::size_t aAmount, ValueAt& aValueAt)
+	{
+		if constexpr (IsDeltaNumber)
+		{
+			std::uint64_t previous = 0;
+			for (std::size_t index = 0; index < aAmount; ++index)
+			{
+				previous += static_cast<std::uint64_t>(CS::BinaryHelper::zigZagDecode(CS::BinaryHelper::readVarint(aColumn)));
+				aValueAt(index) = narrow(previous);
+			}
+		}
+		else
+		{
+			ValueConverter<Type> converter;
+			for (std::size_t index = 0; index < aAmount; ++index)
+			{
+				converter.castBinaryInto(aColumn, aValueAt(index));
+			}
+		}
+	}
+
+	static Type narrow(std::uint64_t aValue)
+	{
+		bool fits = false;
+		if constexpr (std::is_signed_v<Type>)
+		{
+			auto value = static_cast<std::int64_t>(aValue);
+			fits = value >= std::numeric_limits<Type>::min() && value <= std::numeric_limits<Type>::max();
+		}
+		else
+		{
+			fits = aValue <= std::numeric_limits<Type>::max();
+		}
+
+		if (!fits)
+		{
+			CS::Errors::throwExceptionMalformedBinary(CS::TypeHelper::tryGetFullType(CSTypeDefines::csIntegralType));
+		}
+
+		return static_cast<Type>(aValue);
+	}
+};
+
+#endif // !__CS_COLUMN_VALUE_H__
@@ -0,0 +1,209 @@
+#ifndef __CS_COLUMNAR_BATCH_H__
+#define __CS_COLUMNAR_BATCH_H__
+
+#include "CSConvertableStruct.h"
+
+// Encodes a vector of records column by column instead of line by line:
+// the values of one field for all records follow each other under a single
+// type header (see ColumnValue), one column per field in key order.
+//
+//	text, framed: "<records>\n", then every column followed by "\n"
+//	binary:       varint records, then every column after its varint byte length
+//
+//	3
+//	s$a|b|c
+//	i$10|11|12
+//
+// Like values sit together, which suits general purpose compressors, and
+// decodeColumn reads a single field of every record while the other columns
+// are stepped over by their line or length without being parsed.
+template<typename StructType>
+struct ColumnarBatch
+{
+public:
+	static std::string encode(const std::vector<StructType>& aRecords, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		std::string string;
+		encode(aRecords, string, aFormat);
+
+		return string;
+	}
+
+	static void encode(const std::vector<StructType>& aRecords, std::string& aBuffer, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		appendRecordsAmount(aBuffer, aRecords.size(), aFormat);
+
+		for (auto& field : fields())
+		{
+			auto columnStart = aBuffer.size();
+			field.value->appendColumn(firstRecord(aRecords), sizeof(StructType), aRecords.size(), aBuffer, aFormat);
+
+			if (aFormat == CSTypeDefines::WireFormat::Binary)
+			{
+				std::string length;
+				CS::BinaryHelper::appendVarint(length, aBuffer.size() - columnStart);
+				aBuffer.insert(columnStart, length);
+			}
+			else
+			{
+				aBuffer += CSTypeDefines::csRecordDelimiter;
+			}
+		}
+	}
+
+	// Resizes aRecords to the batch and decodes over them. Columns missing
+	// at the end leave their fields untouched, a batch of records without
+	// any column is malformed.
+	static void decode(std::string_view aData, std::vector<StructType>& aRecords, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		auto recordsAmount = readRecordsAmount(aData, aFormat);
+		if (recordsAmount != 0 && aData.empty() && !fields().empty())
+		{
+			CS::Errors::throwExceptionMalformedColumn("columns");
+		}
+
+		aRecords.resize(recordsAmount);
+
+		for (auto& field : fields())
+		{
+			if (aData.empty())
+			{
+				break;
+			}
+
+			field.value->setColumn(firstRecord(aRecords), sizeof(StructType), aRecords.size(), readColumn(aData, aFormat), aFormat);
+		}
+	}
+
+	// Same for the field of aKey alone.
+	static void decodeColumn(std::string_view aData, std::string_view aKey, std::vector<StructType>& aRecords, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		auto index = schema()->indexOf(aKey);
+		if (index == ConvertableSchema::NotFound)
+		{
+			CS::Errors::throwExceptionFieldNotFound(aKey);
+		}
+
+		aRecords.resize(readRecordsAmount(aData, aFormat));
+
+		for (std::size_t skipped = 0; skipped < index; ++skipped)
+		{
+			readColumn(aData, aFormat);
+		}
+
+		if (aData.empty())
+		{
+			CS::Errors::throwExceptionFieldNotFound(aKey);
+		}
+
+		fields()[index].value->setColumn(firstRecord(aRecords), sizeof(StructType), aRecords.size(), readColumn(aData, aFormat), aFormat);
+	}
+
+private:
+	// Schemas live as long as the program, so the pointer is taken once.
+	static const ConvertableSchema* schema()
+	{
+		static const ConvertableSchema* structSchema = StructType().getSchema();
+		return structSchema;
+	}
+
+	static const std::vector<ConvertableSchema::Field>& fields()
+	{
+		static const std::vector<ConvertableSchema::Field> noFields;
+		return schema() ? schema()->getFields() : noFields;
+	}
+
+	// Field offsets are taken from the ConvertableStruct base, which sits at
+	// the same place in every record.
+	static const ConvertableStruct* firstRecord(const std::vector<StructType>& aRecords) { return aRecords.data(); }
+	static ConvertableStruct* firstRecord(std::vector<StructType>& aRecords) { return aRecords.data(); }
+
+	static void appendRecordsAmount(std::string& aBuffer, std::size_t aAmount, CSTypeDefines::WireFormat aFormat)
+	{
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			CS::BinaryHelper::appendVarint(aBuffer, aAmount);
+			return;
+		}
+
+		ValueConverter<std::size_t> amountConverter;
+		amountConverter.appendString(aBuffer, aAmount);
+		aBuffer += CSTypeDefines::csRecordDelimiter;
+	}
+
+	static std::size_t readRecordsAmount(std::string_view& aData, CSTypeDefines::WireFormat aFormat)
+	{
+		std::uint64_t amount = 0;
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			amount = CS::BinaryHelper::readVarint(aData);
+		}
+		else
+		{
+			auto line = readLine(aData);
+			auto [end, error] = std::from_chars(line.data(), line.data() + line.size(), amount);
+			if (error != std::errc{} || end != line.data() + line.size())
+			{
+				CS::Errors::throwExceptionMalformedColumn("records amount");
+			}
+		}
+
+		// Every record but the first takes at least a byte of every column,
+		// larger counts are rejected before anything is allocated for them.
+		CS::Limits::checkCount(amount, CS::Limits::maxVectorElements, CSTypeDefines::csVectorType);
+		if (amount > aData.size() + 1)
+		{
+			CS::Errors::throwExceptionMalformedColumn("records amount");
+		}
+
+		return static_cast<std::size_t>(amount);
+	}
+
+	static std::string_view readColumn(std::string_view& aData, CSTypeDefines::WireFormat aFormat)
+	{
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			auto length = CS::BinaryHelper::readVarint(aData);
+			if (length > aData.size())
+			{
+				CS::Errors::throwExceptionMalformedColumn("column length");
+			}
+
+			return CS::BinaryHelper::readBytes(aData, static_cast<std::size_t>(length));
+		}
+
+		if (aFormat == CSTypeDefines::WireFormat::Framed)
+		{
+			// Frames may hold newlines, the column ends with its frame.
+			auto column = aData;
+			CS::FramingHelper::skipTypedValue(aData);
+			column = column.substr(0, column.size() - aData.size());
+
+			if (aData.substr(0, CSTypeDefines::csRecordDelimiter.size()) != CSTypeDefines::csRecordDelimiter)
+			{
+				CS::Errors::throwExceptionMalformedColumn("column end");
+			}
+
+			aData.remove_prefix(CSTypeDefines::csRecordDelimiter.size());
+			return column;
+		}
+
+		return readLine(aData);
+	}
+
+	static std::string_view readLine(std::string_view& aData)
+	{
+		auto lineEnd = aData.find(CSTypeDefines::csRecordDelimiter);
+		if (lineEnd == std::string_view::npos)
+		{
+			CS::Errors::throwExceptionMalformedColumn("line end");
+		}
+
+		auto line = aData.substr(0, lineEnd);
+		aData.remove_prefix(lineEnd + CSTypeDefines::csRecordDelimiter.size());
+
+		return line;
+	}
+};
+
+#endif // !__CS_COLUMNAR_BATCH_H__
@@ -0,0 +1,377 @@
+#ifndef __CS_CONVERTABLE_FIELDS_H__
+#define __CS_CONVERTABLE_FIELDS_H__
+
+#include "CSValueConverter.h"
+#include "CSFramedValue.h"
+
+#include <tuple>
+#include <utility>
+
+// Compile-time alternative to ConvertableStruct::pushValue. A struct lists its
+// fields once with CS_CONVERTABLE_FIELDS and StaticConvertableStruct generates
+// encode/decode code for exactly those members: no virtual calls, no key map
+// and no per-field heap objects. The wire format is the same as the pushValue
+// path, fields are written in key order just like the std::map there.
+//
+//	struct Point { int x; int y; };
+//	CS_CONVERTABLE_FIELDS(Point, CS_FIELD(x), CS_FIELD(y))
+//
+//	std::string line = StaticConvertableStruct<Point>::convertObjectToLineSave(point);
+
+template<typename StructType, typename MemberType>
+struct ConvertableField
+{
+	using Type = MemberType;
+
+	std::string_view key;
+	MemberType StructType::* member;
+};
+
+template<typename StructType, typename MemberType>
+constexpr ConvertableField<StructType, MemberType> makeConvertableField(std::string_view aKey, MemberType StructType::* aMember)
+{
+	return { aKey, aMember };
+}
+
+// Specialized by CS_CONVERTABLE_FIELDS.
+template<typename StructType>
+struct ConvertableFields;
+
+#define CS_CONVERTABLE_FIELDS(StructName, ...) \
+	template<> \
+	struct ConvertableFields<StructName> \
+	{ \
+		using Struct = StructName; \
+		static constexpr auto fields() { return std::make_tuple(__VA_ARGS__); } \
+	};
+
+#define CS_FIELD(MemberName) makeConvertableField(#MemberName, &Struct::MemberName)
+#define CS_FIELD_NAMED(Key, MemberName) makeConvertableField(Key, &Struct::MemberName)
+
+template<typename StructType>
+struct StaticConvertableStruct
+{
+private:
+	static constexpr auto fields = ConvertableFields<StructType>::fields();
+	static constexpr std::size_t FieldsCount = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+
+	template<std::size_t... Index>
+	static constexpr std::array<std::string_view, FieldsCount> collectKeys(std::index_sequence<Index...>)
+	{
+		return { std::get<Index>(fields).key... };
+	}
+
+	static constexpr std::array<std::string_view, FieldsCount> keys = collectKeys(std::make_index_sequence<FieldsCount>{});
+
+	// Field indices in std::map<std::string, ...> order.
+	static constexpr std::array<std::size_t, FieldsCount> sortKeys()
+	{
+		std::array<std::size_t, FieldsCount> order{};
+		for (std::size_t index = 0; index < FieldsCount; ++index)
+		{
+			order[index] = index;
+		}
+
+		for (std::size_t index = 1; index < FieldsCount; ++index)
+		{
+			for (std::size_t current = index; current > 0 && keys[order[current]] < keys[order[current - 1]]; --current)
+			{
+				auto swapped = order[current];
+				order[current] = order[current - 1];
+				order[current - 1] = swapped;
+			}
+		}
+
+		return order;
+	}
+
+	static constexpr std::array<std::size_t, FieldsCount> order = sortKeys();
+
+	static constexpr bool hasUniqueKeys()
+	{
+		for (std::size_t index = 1; index < FieldsCount; ++index)
+		{
+			if (keys[order[index]] == keys[order[index - 1]])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static_assert(FieldsCount > 0, "CS_CONVERTABLE_FIELDS needs at least one field");
+	static_assert(hasUniqueKeys(), "CS_CONVERTABLE_FIELDS has duplicated keys");
+
+	template<std::size_t Position>
+	using FieldAt = std::decay_t<decltype(std::get<order[Position]>(fields))>;
+
+	template<std::size_t Position>
+	static void appendField(const StructType& aObject, std::string& aBuffer)
+	{
+		if constexpr (Position != 0)
+		{
+			aBuffer += CSTypeDefines::csValueDelimiter;
+		}
+
+		ValueConverter<typename FieldAt<Position>::Type> converter;
+		converter.appendTyped(aBuffer, aObject.*(std::get<order[Position]>(fields).member));
+	}
+
+	template<std::size_t Position>
+	static std::size_t fieldSize(const StructType& aObject)
+	{
+		ValueConverter<typename FieldAt<Position>::Type> converter;
+		return converter.typedSize(aObject.*(std::get<order[Position]>(fields).member));
+	}
+
+	template<std::size_t Position, bool Unchecked>
+	static bool castField(CS::DataHelper::SplitView::iterator& aValueIt, const CS::DataHelper::SplitView::iterator& aEnd, StructType& aObject)
+	{
+		if (aValueIt == aEnd)
+		{
+			return false;
+		}
+
+		ValueConverter<typename FieldAt<Position>::Type> converter;
+		if constexpr (Unchecked)
+		{
+			converter.castUncheckedInto(*aValueIt, aObject.*(std::get<order[Position]>(fields).member));
+		}
+		else
+		{
+			converter.castTypedInto(*aValueIt, aObject.*(std::get<order[Position]>(fields).member));
+		}
+
+		++aValueIt;
+
+		return true;
+	}
+
+	template<std::size_t Position>
+	static void appendBinaryField(const StructType& aObject, std::string& aBuffer)
+	{
+		ValueConverter<typename FieldAt<Position>::Type> converter;
+		converter.appendBinary(aBuffer, aObject.*(std::get<order[Position]>(fields).member));
+	}
+
+	template<std::size_t Position>
+	static std::size_t binaryFieldSize(const StructType& aObject)
+	{
+		ValueConverter<typename FieldAt<Position>::Type> converter;
+		return converter.binarySize(aObject.*(std::get<order[Position]>(fields).member));
+	}
+
+	template<std::size_t Position>
+	static void castBinaryField(std::string_view& aLineSave, StructType& aObject)
+	{
+		ValueConverter<typename FieldAt<Position>::Type> converter;
+		converter.castBinaryInto(aLineSave, aObject.*(std::get<order[Position]>(fields).member));
+	}
+
+	template<std::size_t Position>
+	static void appendFramedField(const StructType& aObject, std::string& aBuffer)
+	{
+		if constexpr (Position != 0)
+		{
+			aBuffer += CSTypeDefines::csValueDelimiter;
+		}
+
+		FramedField::append(aBuffer, aObject.*(std::get<order[Position]>(fields).member));
+	}
+
+	template<std::size_t Position>
+	static std::size_t framedFieldSize(const StructType& aObject)
+	{
+		return FramedField::size(aObject.*(std::get<order[Position]>(fields).member));
+	}
+
+	template<std::size_t Position, bool Unchecked>
+	static bool castFramedField(std::string_view& aLineSave, StructType& aObject)
+	{
+		if (aLineSave.empty())
+		{
+			return false;
+		}
+
+		if constexpr (Position != 0)
+		{
+			CS::FramingHelper::readValueDelimiter(aLineSave);
+		}
+
+		if constexpr (Unchecked)
+		{
+			FramedField::castUncheckedInto(aLineSave, aObject.*(std::get<order[Position]>(fields).member));
+		}
+		else
+		{
+			FramedField::castInto(aLineSave, aObject.*(std::get<order[Position]>(fields).member));
+		}
+
+		return true;
+	}
+
+	template<std::size_t... Position>
+	static void appendFields(const StructType& aObject, std::string& aBuffer, std::index_sequence<Position...>)
+	{
+		(appendField<Position>(aObject, aBuffer), ...);
+	}
+
+	template<std::size_t... Position>
+	static std::size_t fieldsSize(const StructType& aObject, std::index_sequence<Position...>)
+	{
+		return (fieldSize<Position>(aObject) + ...);
+	}
+
+	template<std::size_t... Position>
+	static void appendBinaryFields(const StructType& aObject, std::string& aBuffer, std::index_sequence<Position...>)
+	{
+		(appendBinaryField<Position>(aObject, aBuffer), ...);
+	}
+
+	template<std::size_t... Position>
+	static std::size_t binaryFieldsSize(const StructType& aObject, std::index_sequence<Position...>)
+	{
+		return (binaryFieldSize<Position>(aObject) + ...);
+	}
+
+	template<std::size_t... Position>
+	static void castBinaryFields(std::string_view aLineSave, StructType& aObject, std::index_sequence<Position...>)
+	{
+		(castBinaryField<Position>(aLineSave, aObject), ...);
+
+		if (!aLineSave.empty())
+		{
+			CS::Errors::throwExceptionMalformedBinary("record end");
+		}
+	}
+
+	template<std::size_t... Position>
+	static void appendFramedFields(const StructType& aObject, std::string& aBuffer, std::index_sequence<Position...>)
+	{
+		(appendFramedField<Position>(aObject, aBuffer), ...);
+	}
+
+	template<std::size_t... Position>
+	static std::size_t framedFieldsSize(const StructType& aObject, std::index_sequence<Position...>)
+	{
+		return (framedFieldSize<Position>(aObject) + ...);
+	}
+
+	template<bool Unchecked, std::size_t... Position>
+	static void castFramedFields(std::string_view aLineSave, StructType& aObject, std::index_sequence<Position...>)
+	{
+		static_cast<void>((castFramedField<Position, Unchecked>(aLineSave, aObject) && ...));
+
+		if (!aLineSave.empty())
+		{
+			CS::Errors::throwExceptionMalformedFrame("record end");
+		}
+	}
+
+	template<bool Unchecked, std::size_t... Position>
+	static void castFields(std::string_view aLineSave, StructType& aObject, std::index_sequence<Position...>)
+	{
+		auto splitedProgress = CS::DataHelper::split(aLineSave, CSTypeDefines::csValueDelimiter);
+		auto valueIt = splitedProgress.begin();
+		auto end = splitedProgress.end();
+
+		static_cast<void>((castField<Position, Unchecked>(valueIt, end, aObject) && ...));
+	}
+
+	template<bool Unchecked>
+	static void castObject(std::string_view aLineSave, StructType& aObject, CSTypeDefines::WireFormat aFormat)
+	{
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			castBinaryFields(aLineSave, aObject, std::make_index_sequence<FieldsCount>{});
+		}
+		else if (aFormat == CSTypeDefines::WireFormat::Framed)
+		{
+			castFramedFields<Unchecked>(aLineSave, aObject, std::make_index_sequence<FieldsCount>{});
+		}
+		else
+		{
+			castFields<Unchecked>(aLineSave, aObject, std::make_index_sequence<FieldsCount>{});
+		}
+	}
+
+	template<std::size_t... Position>
+	static constexpr std::uint64_t fieldsFingerprint(std::index_sequence<Position...>)
+	{
+		std::uint64_t fingerprint = CS::TypeHelper::FingerprintSeed;
+		((fingerprint = CS::TypeHelper::fingerprintField(fingerprint, keys[order[Position]], ValueConverter<typename FieldAt<Position>::Type>::signature())), ...);
+
+		return fingerprint;
+	}
+
+public:
+	static constexpr std::size_t fieldsCount() { return FieldsCount; }
+
+	// Same value as ConvertableSchema::fingerprint for a pushValue struct with
+	// these fields, computed at compile time.
+	static constexpr std::uint64_t fingerprint() { return fieldsFingerprint(std::make_index_sequence<FieldsCount>{}); }
+
+	static void convertLineSaveToObject(std::string_view aLineSave, StructType& aObject, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		castObject<false>(aLineSave, aObject, aFormat);
+	}
+
+	// Skips the field type checks when aFingerprint is fingerprint(), see
+	// ConvertableStruct::convertLineSaveToObject.
+	static void convertLineSaveToObject(std::string_view aLineSave, StructType& aObject, std::uint64_t aFingerprint, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		if (aFingerprint == fingerprint())
+		{
+			castObject<true>(aLineSave, aObject, aFormat);
+		}
+		else
+		{
+			castObject<false>(aLineSave, aObject, aFormat);
+		}
+	}
+
+	static std::string convertObjectToLineSave(const StructType& aObject, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		std::string string;
+		string.reserve(encodedSize(aObject, aFormat));
+		convertObjectToLineSave(aObject, string, aFormat);
+
+		return string;
+	}
+
+	static void convertObjectToLineSave(const StructType& aObject, std::string& aBuffer, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			appendBinaryFields(aObject, aBuffer, std::make_index_sequence<FieldsCount>{});
+		}
+		else if (aFormat == CSTypeDefines::WireFormat::Framed)
+		{
+			appendFramedFields(aObject, aBuffer, std::make_index_sequence<FieldsCount>{});
+		}
+		else
+		{
+			appendFields(aObject, aBuffer, std::make_index_sequence<FieldsCount>{});
+		}
+	}
+
+	static std::size_t encodedSize(const StructType& aObject, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			return binaryFieldsSize(aObject, std::make_index_sequence<FieldsCount>{});
+		}
+
+		if (aFormat == CSTypeDefines::WireFormat::Framed)
+		{
+			return framedFieldsSize(aObject, std::make_index_sequence<FieldsCount>{})
+				+ (FieldsCount - 1) * CSTypeDefines::csValueDelimiter.size();
+		}
+
+		return fieldsSize(aObject, std::make_index_sequence<FieldsCount>{})
+			+ (FieldsCount - 1) * CSTypeDefines::csValueDelimiter.size();
+	}
+};
+
+#endif // !__CS_CONVERTABLE_FIELDS_H__
@@ -0,0 +1,209 @@
+#ifndef __CS_CONVERTABLE_SCHEMA_H__
+#define __CS_CONVERTABLE_SCHEMA_H__
+
+#include "CSConvetableValue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <typeinfo>
+
+struct ConvertableSchema;
+
+// Fields picked by key for a projection decode, made by ConvertableSchema::select.
+struct FieldSelection
+{
+	const ConvertableSchema* schema = nullptr;
+	std::vector<bool> selected;
+	// Position after the last selected field, nothing past it has to be read.
+	std::size_t fieldsAmount = 0;
+};
+
+// Field layout of one ConvertableStruct-derived type. Built by the first
+// instance's pushValue calls and shared by every instance after it, so
+// constructing or destroying a struct does not allocate. Once an instance
+// that went through all of its constructors is destroyed the schema is
+// complete, and later instances take neither the registry lock nor the
+// field lookup.
+struct ConvertableSchema
+{
+	struct Field
+	{
+		std::string key;
+		std::ptrdiff_t offset;
+		std::shared_ptr<IConvertableValue> value;
+	};
+
+private:
+	const std::type_info* structType;
+	// Sorted by key, the order fields are written in.
+	std::vector<Field> fields;
+	std::uint64_t fieldsFingerprint = CS::TypeHelper::FingerprintSeed;
+	// Some field is a vector or a map.
+	bool containers = false;
+	// Every field is registered, pushes only repeat what is already there.
+	std::atomic<bool> complete{ false };
+
+	static std::mutex& registryMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	static std::unordered_map<std::type_index, std::unique_ptr<ConvertableSchema>>& registry()
+	{
+		static std::unordered_map<std::type_index, std::unique_ptr<ConvertableSchema>> schemas;
+		return schemas;
+	}
+
+	// Schemas this thread already looked up, found without the registry lock.
+	static std::unordered_map<std::type_index, ConvertableSchema*>& enteredSchemas()
+	{
+		static thread_local std::unordered_map<std::type_index, ConvertableSchema*> schemas;
+		return schemas;
+	}
+
+	static ConvertableSchema& findOrCreate(const std::type_info& aStructType, const ConvertableSchema* aBaseSchema)
+	{
+		std::lock_guard<std::mutex> lock(registryMutex());
+
+		auto& schemas = registry();
+		auto findIt = schemas.find(std::type_index(aStructType));
+		if (findIt != schemas.end())
+		{
+			return *findIt->second;
+		}
+
+		auto schema = std::make_unique<ConvertableSchema>(aStructType);
+		if (aBaseSchema)
+		{
+			schema->fields = aBaseSchema->fields;
+			schema->fieldsFingerprint = aBaseSchema->fieldsFingerprint;
+			schema->containers = aBaseSchema->containers;
+		}
+
+		return *schemas.emplace(std::type_index(aStructType), std::move(schema)).first->second;
+	}
+
+	std::vector<Field>::iterator lowerBound(std::string_view aKey)
+	{
+		return std::lower_bound(fields.begin(), fields.end(), aKey,
+			[](const Field& aField, std::string_view aKey) { return aField.key < aKey; });
+	}
+
+	std::vector<Field>::const_iterator lowerBound(std::string_view aKey) const
+	{
+		return std::lower_bound(fields.begin(), fields.end(), aKey,
+			[](const Field& aField, std::string_view aKey) { return aField.key < aKey; });
+	}
+
+public:
+	explicit ConvertableSchema(const std::type_info& aStructType) : structType{ &aStructType } {}
+
+	// Schema of aStructType, created on first use. A new schema starts with
+	// aBaseSchema's fields, which the base class constructors already pushed.
+	static ConvertableSchema& acquire(const std::type_info& aStructType, const ConvertableSchema* aBaseSchema)
+	{
+		auto& entered = enteredSchemas();
+		auto enteredIt = entered.find(std::type_index(aStructType));
+		if (enteredIt != entered.end())
+		{
+			return *enteredIt->second;
+		}
+
+		auto& schema = findOrCreate(aStructType, aBaseSchema);
+		entered.emplace(std::type_index(aStructType), &schema);
+
+		return schema;
+	}
+
+	// Called when an instance that finished all of its constructors goes
+	// away, every field of the type has been pushed by then. An instance
+	// whose constructor threw halfway must not call it.
+	void markComplete()
+	{
+		if (!complete.load(std::memory_order_relaxed))
+		{
+			complete.store(true, std::memory_order_release);
+		}
+	}
+
+	// Adds the field the first time it is pushed. Later instances push the same
+	// key and offset again and only get validated, until the schema is complete.
+	template<typename Type>
+	void registerValue(std::string_view aKey, std::ptrdiff_t aOffset)
+	{
+		if (complete.load(std::memory_order_acquire))
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(registryMutex());
+
+		auto findIt = lowerBound(aKey);
+		if (findIt != fields.end() && findIt->key == aKey)
+		{
+			if (findIt->offset != aOffset)
+			{
+				CS::Errors::throwExceptionTypeRedefinition(std::string(aKey));
+			}
+
+			return;
+		}
+
+		auto inserted = fields.insert(findIt, Field{ std::string(aKey), aOffset, std::make_shared<ConvertableValue<Type>>(aOffset) });
+		containers = containers || inserted->value->hasElements();
+
+		fieldsFingerprint = CS::TypeHelper::FingerprintSeed;
+		for (auto& field : fields)
+		{
+			fieldsFingerprint = CS::TypeHelper::fingerprintField(fieldsFingerprint, field.key, field.value->signature());
+		}
+	}
+
+	static constexpr std::size_t NotFound = static_cast<std::size_t>(-1);
+
+	// Position of the field in key order, which is its position in a line save.
+	std::size_t indexOf(std::string_view aKey) const
+	{
+		auto findIt = lowerBound(aKey);
+		if (findIt != fields.end() && findIt->key == aKey)
+		{
+			return static_cast<std::size_t>(findIt - fields.begin());
+		}
+
+		return NotFound;
+	}
+
+	// Marks the fields named in aKeys. Unknown keys are ignored.
+	template<typename Keys>
+	FieldSelection select(const Keys& aKeys) const
+	{
+		FieldSelection selection{ this, std::vector<bool>(fields.size(), false), 0 };
+		for (auto& key : aKeys)
+		{
+			auto index = indexOf(key);
+			if (index != NotFound)
+			{
+				selection.selected[index] = true;
+				selection.fieldsAmount = std::max(selection.fieldsAmount, index + 1);
+			}
+		}
+
+		return selection;
+	}
+
+	bool describes(const std::type_info& aStructType) const { return *structType == aStructType; }
+
+	// Hash of every key and field signature. Structs with the same fields of
+	// the same types share it, CS_CONVERTABLE_FIELDS ones included.
+	std::uint64_t fingerprint() const { return fieldsFingerprint; }
+
+	const std::vector<Field>& getFields() const { return fields; }
+
+	bool hasContainers() const { return containers; }
+};
+
+#endif // !__CS_CONVERTABLE_SCHEMA_H__
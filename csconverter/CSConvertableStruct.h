@@ -31,80 +31,586 @@
 #define __CS_CONVERTABLE_STRUCT_H__
 
 #include "CSHelper.h"
-#include "CSConvetableValue.h"
+#include "CSConvertableSchema.h"
 
+#include <algorithm>
+#include <exception>
+
+// Where and why ConvertableStruct::tryConvertLineSaveToObject failed. offset
+// is the byte of the line save the failing value starts at, key is empty
+// when no field was being read (e.g. bytes left after the last one).
+struct DecodeError
+{
+	CSTypeDefines::DecodeStatus status = CSTypeDefines::DecodeStatus::Ok;
+	std::size_t offset = 0;
+	std::string_view key;
+
+	// Only built when asked for, e.g. for a log line.
+	std::string message() const
+	{
+		std::string string = statusName();
+		string += " at byte " + std::to_string(offset);
+		if (!key.empty())
+		{
+			string += " in field ";
+			string += key;
+		}
+
+		return string;
+	}
+
+	const char* statusName() const
+	{
+		switch (status)
+		{
+		case CSTypeDefines::DecodeStatus::Ok: return "Ok";
+		case CSTypeDefines::DecodeStatus::TypeMismatch: return "Type mismatch";
+		case CSTypeDefines::DecodeStatus::FailedToParse: return "Parse error";
+		case CSTypeDefines::DecodeStatus::MalformedBinary: return "Malformed binary";
+		case CSTypeDefines::DecodeStatus::MalformedFrame: return "Malformed frame";
+		case CSTypeDefines::DecodeStatus::MalformedColumn: return "Malformed column";
+		case CSTypeDefines::DecodeStatus::MalformedHeader: return "Malformed header";
+		case CSTypeDefines::DecodeStatus::MalformedDelta: return "Malformed delta";
+		case CSTypeDefines::DecodeStatus::CountOverLimit: return "Count over limit";
+		case CSTypeDefines::DecodeStatus::TokenOverLimit: return "Token over limit";
+		}
+
+		return "Unknown error";
+	}
+};
+
+// Outcome of a non-throwing decode, used like std::expected<void, DecodeError>:
+//
+//	if (auto result = record.tryConvertLineSaveToObject(line); !result)
+//	{
+//		log(result.error().message());
+//	}
+struct DecodeResult
+{
+public:
+	DecodeResult() = default;
+	DecodeResult(const DecodeError& aError) : failure{ aError } {}
+
+	explicit operator bool() const { return failure.status == CSTypeDefines::DecodeStatus::Ok; }
+
+	const DecodeError& error() const { return failure; }
+
+private:
+	DecodeError failure;
+};
+
+// Fields are registered with pushValue in the derived constructor. Pointers
+// must point into the struct itself: they are stored as offsets in a schema
+// shared by all instances of the same type, so the instance only keeps a
+// pointer to that schema.
 struct ConvertableStruct
 {
 private:
-	std::map<std::string, IConvertableValue*> keyValue;
-public:
-	ConvertableStruct() {};
-	virtual ~ConvertableStruct() 
+	ConvertableSchema* schema = nullptr;
+
+	template<typename Type>
+	void registerValue(std::string_view aKey, Type* aValuePointer)
 	{
-		for (auto& [_, value] : keyValue)
+		if (!aValuePointer)
 		{
-			if (value)
+			CS::Errors::throwExceptionFailedToWrieNullptr(std::string(aKey));
+		}
+
+		// During a base class constructor typeid names the base, so every level
+		// of a hierarchy gets its own schema extending the previous one.
+		const std::type_info& structType = typeid(*this);
+		if (!schema || !schema->describes(structType))
+		{
+			schema = &ConvertableSchema::acquire(structType, schema);
+		}
+
+		auto offset = reinterpret_cast<const char*>(aValuePointer) - reinterpret_cast<const char*>(this);
+		schema->registerValue<Type>(aKey, offset);
+	}
+
+	// tryDecodeFields with the failure thrown as the usual CS::Errors exception.
+	void decodeFields(std::string_view aLineSave, CSTypeDefines::WireFormat aFormat, bool aUnchecked)
+	{
+		auto result = tryDecodeFields(aLineSave, aFormat, aUnchecked);
+		if (result)
+		{
+			return;
+		}
+
+		auto& error = result.error();
+		if (error.key.empty())
+		{
+			if (aFormat == CSTypeDefines::WireFormat::Binary)
 			{
-				delete value;
-				value = nullptr;
+				CS::Errors::throwExceptionMalformedBinary("record end");
 			}
+
+			CS::Errors::throwExceptionMalformedFrame("record end");
+		}
+
+		auto signature = schema->getFields()[schema->indexOf(error.key)].value->signature();
+		auto value = aLineSave.substr(error.offset);
+		CS::Errors::throwExceptionWithStatus(error.status, value.substr(0, value.find(CSTypeDefines::csValueDelimiter)), 
+			signature.substr(0, signature.find(CSTypeDefines::csTypeDelimiter)));
+	}
+
+	// Fields before a failing one keep their decoded values. With aUnchecked
+	// the type headers are skipped instead of compared.
+	DecodeResult tryDecodeFields(std::string_view aLineSave, CSTypeDefines::WireFormat aFormat, bool aUnchecked)
+	{
+		if (!schema)
+		{
+			return {};
+		}
+
+		auto lineStart = aLineSave.data();
+		auto failure = [lineStart](CSTypeDefines::DecodeStatus aStatus, std::string_view aValue, std::string_view aKey)
+		{
+			return DecodeError{ aStatus, static_cast<std::size_t>(aValue.data() - lineStart), aKey };
+		};
+
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			for (auto& field : schema->getFields())
+			{
+				auto value = aLineSave;
+				auto status = field.value->trySetBinary(this, aLineSave);
+				if (status != CSTypeDefines::DecodeStatus::Ok)
+				{
+					return failure(status, value, field.key);
+				}
+			}
+
+			if (!aLineSave.empty())
+			{
+				return failure(CSTypeDefines::DecodeStatus::MalformedBinary, aLineSave, {});
+			}
+
+			return {};
+		}
+
+		if (aFormat == CSTypeDefines::WireFormat::Framed)
+		{
+			auto& fields = schema->getFields();
+			for (std::size_t index = 0; index < fields.size() && !aLineSave.empty(); ++index)
+			{
+				if (index != 0 && !CS::FramingHelper::tryReadValueDelimiter(aLineSave))
+				{
+					return failure(CSTypeDefines::DecodeStatus::MalformedFrame, aLineSave, fields[index].key);
+				}
+
+				auto value = aLineSave;
+				auto status = fields[index].value->trySetFramed(this, aLineSave, aUnchecked);
+				if (status != CSTypeDefines::DecodeStatus::Ok)
+				{
+					return failure(status, value, fields[index].key);
+				}
+			}
+
+			if (!aLineSave.empty())
+			{
+				return failure(CSTypeDefines::DecodeStatus::MalformedFrame, aLineSave, {});
+			}
+
+			return {};
+		}
+
+		// Long lines with containers get one pass that finds every delimiter,
+		// the fields and the elements of their containers are then cut from
+		// the positions. Other lines are split as they are read.
+		if (schema->hasContainers() && aLineSave.size() >= IndexedLineSize)
+		{
+			auto& index = lineIndex();
+			index.build(aLineSave);
+
+			return tryDecodeTextFields(index.split(CSTypeDefines::csValueDelimiter), aUnchecked, &index, failure);
+		}
+
+		return tryDecodeTextFields(CS::DataHelper::split(aLineSave, CSTypeDefines::csValueDelimiter), aUnchecked, nullptr, failure);
+	}
+
+	template<typename Split, typename Failure>
+	DecodeResult tryDecodeTextFields(const Split& aSplit, bool aUnchecked, const StructuralIndex* aIndex, const Failure& aFailure)
+	{
+		auto valueIt = aSplit.begin();
+
+		for (auto& field : schema->getFields())
+		{
+			if (valueIt == aSplit.end())
+			{
+				break;
+			}
+
+			auto value = *valueIt;
+			auto status = field.value->trySetValue(this, value, aUnchecked, aIndex);
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return aFailure(status, value, field.key);
+			}
+
+			++valueIt;
+		}
+
+		return {};
+	}
+
+	// Shorter lines are split faster than they are indexed.
+	static constexpr std::size_t IndexedLineSize = 4096;
+
+	// Kept per thread, so its position buffer is reused from line to line.
+	static StructuralIndex& lineIndex()
+	{
+		thread_local StructuralIndex index;
+		return index;
+	}
+
+	bool checkDeltaBase(const ConvertableStruct& aPrevious) const
+	{
+		if (aPrevious.schema != schema)
+		{
+			CS::Errors::throwExceptionDeltaBaseMismatch();
+		}
+
+		return schema != nullptr;
+	}
+
+public:
+	ConvertableStruct() {};
+	// A base destructor also runs when a derived constructor throws, possibly
+	// before all fields were pushed, so the schema is completed only by an
+	// instance destroyed outside of an exception.
+	virtual ~ConvertableStruct()
+	{
+		if (schema && std::uncaught_exceptions() == 0)
+		{
+			schema->markComplete();
 		}
 	};
 
-	void convertLineSaveToObject(const std::string& aLineSave)
+	// Instances only share an immutable schema, so copies and moves need no
+	// re-registration and structs can be stored by value, e.g. in std::vector.
+	ConvertableStruct(const ConvertableStruct& aOther) noexcept : schema{ aOther.schema } {};
+	ConvertableStruct(ConvertableStruct&& aOther) noexcept : schema{ aOther.schema } {};
+
+	// The schema describes this object's own type, which assignment never changes.
+	ConvertableStruct& operator=(const ConvertableStruct&) noexcept { return *this; };
+	ConvertableStruct& operator=(ConvertableStruct&&) noexcept { return *this; };
+
+	// Decodes over the current field values. Strings, vectors and maps are
+	// replaced but keep their capacity and map nodes, so decoding a stream into
+	// one reused object stops allocating once its largest record was seen.
+	void convertLineSaveToObject(std::string_view aLineSave, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		decodeFields(aLineSave, aFormat, false);
+	}
+
+	// Same for a record written by a struct with schema fingerprint aFingerprint,
+	// e.g. from a LineSaveReader header. When it is this struct's own, the
+	// type headers of the fields are skipped instead of compared; any other
+	// fingerprint decodes with the usual checks. Binary has no headers.
+	void convertLineSaveToObject(std::string_view aLineSave, std::uint64_t aFingerprint, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		decodeFields(aLineSave, aFormat, schema && aFingerprint == schema->fingerprint());
+	}
+
+	// Same as convertLineSaveToObject, but malformed input is returned as a
+	// DecodeError instead of thrown; no exception is raised on the way for
+	// any field type. Fields before the failing one keep their decoded values.
+	DecodeResult tryConvertLineSaveToObject(std::string_view aLineSave, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		return tryDecodeFields(aLineSave, aFormat, false);
+	}
+
+	DecodeResult tryConvertLineSaveToObject(std::string_view aLineSave, std::uint64_t aFingerprint, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		return tryDecodeFields(aLineSave, aFormat, schema && aFingerprint == schema->fingerprint());
+	}
+
+	// Selection for the projection decode below. Build it once and reuse it
+	// for every record of a stream.
+	template<typename Keys = std::initializer_list<std::string_view>>
+	FieldSelection selectFields(const Keys& aKeys) const
+	{
+		return schema ? schema->select(aKeys) : FieldSelection{};
+	}
+
+	// Decodes only the selected fields and leaves the others untouched.
+	// Skipped values are stepped over without being parsed (by their length
+	// in the framed format), and reading stops after the last selected field.
+	void convertLineSaveToObject(std::string_view aLineSave, const FieldSelection& aSelection, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
 	{
-		auto splitedProgress = CS::DataHelper::splitString(aLineSave, CSTypeDefines::csValueDelimiter);
-		std::reverse(splitedProgress.begin(), splitedProgress.end());
+		if (!schema)
+		{
+			return;
+		}
+
+		if (aSelection.schema != schema)
+		{
+			CS::Errors::throwExceptionSelectionMismatch();
+		}
+
+		auto& fields = schema->getFields();
+
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			for (std::size_t index = 0; index < aSelection.fieldsAmount; ++index)
+			{
+				if (aSelection.selected[index])
+				{
+					fields[index].value->setBinary(this, aLineSave);
+				}
+				else
+				{
+					fields[index].value->skipBinary(aLineSave);
+				}
+			}
 
-		for (auto& [key, valueVar] : keyValue)
+			return;
+		}
+
+		if (aFormat == CSTypeDefines::WireFormat::Framed)
 		{
-			valueVar->setValue(splitedProgress.back());
-			splitedProgress.pop_back();
+			for (std::size_t index = 0; index < aSelection.fieldsAmount && !aLineSave.empty(); ++index)
+			{
+				if (index != 0)
+				{
+					CS::FramingHelper::readValueDelimiter(aLineSave);
+				}
+
+				if (aSelection.selected[index])
+				{
+					fields[index].value->setFramed(this, aLineSave);
+				}
+				else
+				{
+					CS::FramingHelper::skipTypedValue(aLineSave);
+				}
+			}
+
+			return;
+		}
+
+		auto splitedProgress = CS::DataHelper::split(aLineSave, CSTypeDefines::csValueDelimiter);
+		auto valueIt = splitedProgress.begin();
+
+		for (std::size_t index = 0; index < aSelection.fieldsAmount && valueIt != splitedProgress.end(); ++index)
+		{
+			if (aSelection.selected[index])
+			{
+				fields[index].value->setValue(this, *valueIt);
+			}
+
+			// Not advancing past the last selected field spares scanning the next one.
+			if (index + 1 < aSelection.fieldsAmount)
+			{
+				++valueIt;
+			}
 		}
 	}
 
-	std::string convertObjectToLineSave()
+	// Same for keys given as a braced list or any container of keys. Numbers
+	// are fingerprints and go to the overload above.
+	template<typename Keys = std::initializer_list<std::string_view>, typename = std::enable_if_t<!std::is_arithmetic_v<Keys>>>
+	void convertLineSaveToObject(std::string_view aLineSave, const Keys& aKeys, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		convertLineSaveToObject(aLineSave, selectFields(aKeys), aFormat);
+	}
+
+	std::string convertObjectToLineSave(CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
 	{
 		std::string string;
-		auto keysAmount = keyValue.size();
+		string.reserve(encodedSize(aFormat));
+		convertObjectToLineSave(string, aFormat);
+
+		return string;
+	}
 
-		for (auto& [key, valueVar] : keyValue)
+	// Appends the line save to aBuffer. Reusing the same buffer (clear() keeps
+	// its capacity) makes re-encoding the same struct allocation free.
+	void convertObjectToLineSave(std::string& aBuffer, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		if (!schema)
 		{
-			string += valueVar->asString();
+			return;
+		}
+
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			// Fields follow each other without separators, each one knows its length.
+			for (auto& field : schema->getFields())
+			{
+				field.value->appendBinary(this, aBuffer);
+			}
+
+			return;
+		}
+
+		auto keysAmount = schema->getFields().size();
+
+		for (auto& field : schema->getFields())
+		{
+			if (aFormat == CSTypeDefines::WireFormat::Framed)
+			{
+				field.value->appendFramed(this, aBuffer);
+			}
+			else
+			{
+				field.value->appendTo(this, aBuffer);
+			}
+
 			if (--keysAmount != 0)
 			{
-				string += CSTypeDefines::csValueDelimiter;
+				aBuffer += CSTypeDefines::csValueDelimiter;
 			}
 		}
+	}
+
+	// Exact length of convertObjectToLineSave() output.
+	std::size_t encodedSize(CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		if (!schema || schema->getFields().empty())
+		{
+			return 0;
+		}
+
+		std::size_t size = 0;
+		if (aFormat == CSTypeDefines::WireFormat::Binary)
+		{
+			for (auto& field : schema->getFields())
+			{
+				size += field.value->binarySize(this);
+			}
+
+			return size;
+		}
+
+		for (auto& field : schema->getFields())
+		{
+			size += aFormat == CSTypeDefines::WireFormat::Framed ? field.value->framedSize(this) : field.value->encodedSize(this);
+		}
+
+		return size + (schema->getFields().size() - 1) * CSTypeDefines::csValueDelimiter.size();
+	}
+
+	// Keys of the fields that differ from aPrevious, an earlier copy of this object.
+	std::vector<std::string_view> changedFields(const ConvertableStruct& aPrevious) const
+	{
+		std::vector<std::string_view> keys;
+		if (!checkDeltaBase(aPrevious))
+		{
+			return keys;
+		}
+
+		for (auto& field : schema->getFields())
+		{
+			if (!field.value->equals(this, &aPrevious))
+			{
+				keys.push_back(field.key);
+			}
+		}
+
+		return keys;
+	}
+
+	// Encodes only what changed since aPrevious, an earlier copy of this object.
+	// Vectors that grew or shrank at the end and maps send just the appended,
+	// removed or changed elements. Empty when nothing changed.
+	std::string convertObjectToDelta(const ConvertableStruct& aPrevious, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text) const
+	{
+		std::string string;
+		convertObjectToDelta(aPrevious, string, aFormat);
+
 		return string;
 	}
 
-	template<typename Type>
-	void pushValue(const std::string& aKey, Type* aValuePointer)
+	void convertObjectToDelta(const ConvertableStruct& aPrevious, std::string& aBuffer, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text) const
 	{
-		auto findIt = keyValue.find(aKey);
-		if (findIt == keyValue.end())
+		if (!checkDeltaBase(aPrevious))
 		{
-			keyValue.emplace(aKey, new ConvertableValue<Type>(aKey, aValuePointer));
+			return;
 		}
-		else
+
+		DeltaWriter writer(aBuffer, aFormat);
+
+		auto& fields = schema->getFields();
+		for (std::size_t index = 0; index < fields.size(); ++index)
 		{
-			CS::Errors::throwExceptionTypeRedefinition(aKey);
+			writer.setField(index);
+			fields[index].value->appendDelta(this, &aPrevious, writer);
 		}
 	}
 
-	template<typename Type>
-	void pushPointer(const std::string& aKey, Type** aValuePointer)
+	// Applies a delta made by convertObjectToDelta against the state this object is in.
+	void applyDelta(std::string_view aDelta, CSTypeDefines::WireFormat aFormat = CSTypeDefines::WireFormat::Text)
+	{
+		if (!schema)
+		{
+			return;
+		}
+
+		DeltaReader reader(aDelta, aFormat);
+
+		auto& fields = schema->getFields();
+		std::size_t fieldIndex = 0;
+		CSTypeDefines::DeltaOperation operation;
+		while (reader.nextEntry(fieldIndex, operation))
+		{
+			if (fieldIndex >= fields.size())
+			{
+				CS::Errors::throwExceptionMalformedDelta("field index " + std::to_string(fieldIndex));
+			}
+
+			fields[fieldIndex].value->applyDelta(this, operation, reader);
+		}
+	}
+
+	const ConvertableSchema* getSchema() const { return schema; }
+
+	// Fingerprint of this struct's fields, see ConvertableSchema::fingerprint.
+	std::uint64_t fingerprint() const { return schema ? schema->fingerprint() : CS::TypeHelper::FingerprintSeed; }
+
+	// Encode and decode counters of every field of this struct type, see
+	// CSFieldStats.h. Without CS_FIELD_STATS the report holds no fields.
+	FieldStatsReport fieldStats() const
 	{
-		auto findIt = keyValue.find(aKey);
-		if (findIt == keyValue.end())
+		FieldStatsReport report;
+#if defined(CS_FIELD_STATS)
+		if (schema)
 		{
-			keyValue.emplace(aKey, new ConvertableValue<Type>(aKey, aValuePointer));
+			for (auto& field : schema->getFields())
+			{
+				report.fields.push_back(field.value->stats.snapshot(field.key));
+			}
 		}
-		else
+#endif
+
+		return report;
+	}
+
+	// Zeroes the counters of every field of this struct type.
+	void resetFieldStats()
+	{
+#if defined(CS_FIELD_STATS)
+		if (schema)
 		{
-			CS::Errors::throwExceptionTypeRedefinition(aKey);
+			for (auto& field : schema->getFields())
+			{
+				field.value->stats.reset();
+			}
 		}
+#endif
+	}
+
+	template<typename Type>
+	void pushValue(std::string_view aKey, Type* aValuePointer)
+	{
+		registerValue(aKey, aValuePointer);
+	}
+
+	template<typename Type>
+	void pushPointer(std::string_view aKey, Type** aValuePointer)
+	{
+		registerValue(aKey, aValuePointer);
 	}
 };
 
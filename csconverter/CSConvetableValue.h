@@ -2,138 +2,286 @@
 #define __CS_CONVERTABLE_VALUE_H__
 
 #include "CSValueConverter.h"
+#include "CSValueDelta.h"
+#include "CSColumnValue.h"
+#include "CSFieldStats.h"
 
+#include <cstddef>
+
+// Field accessor shared by every instance of a struct type. aObject is the
+// address the field offset was taken from (the ConvertableStruct subobject).
 struct IConvertableValue
 {
-	virtual void setValue(const std::string& aValue) {};
-	virtual std::string asString() { return ""; };
+	virtual std::string_view signature() { return {}; };
+	virtual void setValue(void* aObject, std::string_view aValue) {};
+	virtual void setUncheckedValue(void* aObject, std::string_view aValue) {};
+	// Non-throwing forms of the two above and of setBinary, setFramed and
+	// setUncheckedFramed. aIndex, when given, was built over the line save aValue lies in.
+	virtual CSTypeDefines::DecodeStatus trySetValue(void* aObject, std::string_view aValue, bool aUnchecked, const StructuralIndex* aIndex) { return CSTypeDefines::DecodeStatus::Ok; };
+	virtual CSTypeDefines::DecodeStatus trySetBinary(void* aObject, std::string_view& aValue) { return CSTypeDefines::DecodeStatus::Ok; };
+	virtual CSTypeDefines::DecodeStatus trySetFramed(void* aObject, std::string_view& aValue, bool aUnchecked) { return CSTypeDefines::DecodeStatus::Ok; };
+	virtual std::string asString(const void* aObject) { return ""; };
+	virtual void appendTo(const void* aObject, std::string& aBuffer) {};
+	virtual std::size_t encodedSize(const void* aObject) { return 0; };
+	virtual void setBinary(void* aObject, std::string_view& aValue) {};
+	virtual void skipBinary(std::string_view& aValue) {};
+	virtual void appendBinary(const void* aObject, std::string& aBuffer) {};
+	virtual std::size_t binarySize(const void* aObject) { return 0; };
+	// Element by element text decoding of vectors and maps, see LineSaveParser.
+	// aSpare is kept by the caller for the field, maps park their nodes in it.
+	virtual bool hasElements() { return false; };
+	virtual void beginElements(void* aObject, std::size_t aCount, bool aHasCount, std::shared_ptr<void>& aSpare) {};
+	virtual void setElement(void* aObject, std::size_t aIndex, std::string_view aElement, std::shared_ptr<void>& aSpare) {};
+	virtual void endElements(void* aObject, std::size_t aAmount, std::size_t aCount, bool aHasCount, std::shared_ptr<void>& aSpare) {};
+	virtual void setFramed(void* aObject, std::string_view& aValue) {};
+	virtual void setUncheckedFramed(void* aObject, std::string_view& aValue) {};
+	virtual void appendFramed(const void* aObject, std::string& aBuffer) {};
+	virtual std::size_t framedSize(const void* aObject) { return 0; };
+	// Columns of ColumnarBatch. aObjects is the first of aAmount structs that lie aStride bytes apart.
+	virtual void appendColumn(const void* aObjects, std::size_t aStride, std::size_t aAmount, std::string& aBuffer, CSTypeDefines::WireFormat aFormat) {};
+	virtual void setColumn(void* aObjects, std::size_t aStride, std::size_t aAmount, std::string_view aColumn, CSTypeDefines::WireFormat aFormat) {};
+	virtual bool equals(const void* aObject, const void* aOther) { return true; };
+	virtual void appendDelta(const void* aObject, const void* aPrevious, DeltaWriter& aWriter) {};
+	virtual void applyDelta(void* aObject, CSTypeDefines::DeltaOperation aOperation, DeltaReader& aReader) {};
 	virtual ~IConvertableValue() {};
+
+#if defined(CS_FIELD_STATS)
+	FieldStats stats;
+#endif
 };
 
 template <typename Type, typename TypeDefiniton = void>
 struct ConvertableValue : public IConvertableValue
 {
 private:
-	std::string valueName;
-	Type* valuePointer;
+	std::ptrdiff_t valueOffset;
 
-public:
-	ConvertableValue(const std::string& aValueName, Type* aValuePtr) 
-		: valueName{aValueName}, 
-		valuePointer{aValuePtr} {};
+	static constexpr bool HasElements = CS::TypeHelper::IsVector<Type>::value || CS::TypeHelper::IsMap<Type>::value;
+
+	Type& valueOf(void* aObject) { return *reinterpret_cast<Type*>(static_cast<char*>(aObject) + valueOffset); }
+	const Type& valueOf(const void* aObject) { return *reinterpret_cast<const Type*>(static_cast<const char*>(aObject) + valueOffset); }
 
-	void setValue(const std::string& aValue) override
+	// The statistics scope counts the errors that are thrown, the try setters report theirs here.
+	CSTypeDefines::DecodeStatus countFailure(CSTypeDefines::DecodeStatus aStatus)
 	{
-		if (valuePointer)
+#if defined(CS_FIELD_STATS)
+		if (aStatus != CSTypeDefines::DecodeStatus::Ok)
 		{
-			ValueConverter<Type> converter;
-			*valuePointer = std::move(converter.castTyped(aValue));
-		}
-		else
-		{
-			CS::Errors::throwExceptionFailedToWrieNullptr(valueName);
+			stats.errors.fetch_add(1, std::memory_order_relaxed);
+			if (aStatus == CSTypeDefines::DecodeStatus::TypeMismatch)
+			{
+				stats.typeMismatches.fetch_add(1, std::memory_order_relaxed);
+			}
 		}
+#endif
+		return aStatus;
+	}
+
+public:
+	explicit ConvertableValue(std::ptrdiff_t aValueOffset) 
+		: valueOffset{aValueOffset} {};
+
+	std::string_view signature() override
+	{
+		return ValueConverter<Type>::signature();
 	};
 
-	std::string asString() override
+	void setValue(void* aObject, std::string_view aValue) override
 	{
-		std::string result;
-		if (valuePointer)
+		CS_FIELD_STATS_SCOPE(stats, aValue.size());
+		ValueConverter<Type> converter;
+		converter.castTypedInto(aValue, valueOf(aObject));
+	};
+
+	void setUncheckedValue(void* aObject, std::string_view aValue) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aValue.size());
+		ValueConverter<Type> converter;
+		converter.castUncheckedInto(aValue, valueOf(aObject));
+	};
+
+	// Vectors and maps cut their elements from aIndex instead of searching
+	// for the delimiters again.
+	CSTypeDefines::DecodeStatus trySetValue(void* aObject, std::string_view aValue, bool aUnchecked, const StructuralIndex* aIndex) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aValue.size());
+		ValueConverter<Type> converter;
+
+		if constexpr (HasElements)
 		{
-			ValueConverter<Type> converter;
-			result = converter.toTyped(*valuePointer);
+			return countFailure(aUnchecked ? converter.tryCastUncheckedInto(aValue, valueOf(aObject), aIndex) : converter.tryCastTypedInto(aValue, valueOf(aObject), aIndex));
 		}
 		else
 		{
-			CS::Errors::throwExceptionFailedToReadNullptr(valueName);
+			return countFailure(aUnchecked ? converter.tryCastUncheckedInto(aValue, valueOf(aObject)) : converter.tryCastTypedInto(aValue, valueOf(aObject)));
 		}
+	};
+
+	std::string asString(const void* aObject) override
+	{
+		std::string result;
+		result.reserve(encodedSize(aObject));
+		appendTo(aObject, result);
 
 		return result;
 	};
-};
 
-template<typename MapType>
-struct ConvertableValue<MapType, CS::TypeHelper::isMap<MapType>> : public IConvertableValue
-{
-private:
-	std::string valueName;
-	MapType* valuePointer;
+	void appendTo(const void* aObject, std::string& aBuffer) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aBuffer);
+		ValueConverter<Type> converter;
+		converter.appendTyped(aBuffer, valueOf(aObject));
+	};
 
-public:
-	using KeyType = typename MapType::key_type;
-	using ValueType = typename MapType::mapped_type;
+	std::size_t encodedSize(const void* aObject) override
+	{
+		ValueConverter<Type> converter;
+		return converter.typedSize(valueOf(aObject));
+	};
+
+	void setBinary(void* aObject, std::string_view& aValue) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aValue);
+		ValueConverter<Type> converter;
+		converter.castBinaryInto(aValue, valueOf(aObject));
+	};
+
+	CSTypeDefines::DecodeStatus trySetBinary(void* aObject, std::string_view& aValue) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aValue);
+		ValueConverter<Type> converter;
+		return countFailure(converter.tryCastBinaryInto(aValue, valueOf(aObject)));
+	};
+
+	void skipBinary(std::string_view& aValue) override
+	{
+		ValueConverter<Type> converter;
+		converter.skipBinary(aValue);
+	};
+
+	void appendBinary(const void* aObject, std::string& aBuffer) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aBuffer);
+		ValueConverter<Type> converter;
+		converter.appendBinary(aBuffer, valueOf(aObject));
+	};
+
+	std::size_t binarySize(const void* aObject) override
+	{
+		ValueConverter<Type> converter;
+		return converter.binarySize(valueOf(aObject));
+	};
 
-	ConvertableValue(const std::string& aValueName, MapType* aValuePtr) : valueName{ aValueName }, valuePointer{ aValuePtr } {}
-	void setValue(const std::string& aValue) override
+	bool hasElements() override
 	{
-		ValueConverter<KeyType> keyConverter;
-		ValueConverter<ValueType> valueConverter;
+		return HasElements;
+	};
 
-		MapType& map = *valuePointer;
+	void beginElements(void* aObject, std::size_t aCount, bool aHasCount, std::shared_ptr<void>& aSpare) override
+	{
+		if constexpr (HasElements)
+		{
+			ValueConverter<Type> converter;
+			if constexpr (CS::TypeHelper::IsMap<Type>::value)
+			{
+				converter.beginElements(aCount, aHasCount, valueOf(aObject), aSpare);
+			}
+			else
+			{
+				converter.beginElements(aCount, aHasCount);
+			}
+		}
+	};
 
-		auto splitedMapData = CS::DataHelper::splitString(aValue, CSTypeDefines::csTypeDelimiter);
-		if (splitedMapData.size() == 3)
+	void setElement(void* aObject, std::size_t aIndex, std::string_view aElement, std::shared_ptr<void>& aSpare) override
+	{
+		if constexpr (HasElements)
 		{
-			const auto& mapType = splitedMapData[0];
-			const auto& mapInnerType = splitedMapData[1];
-			const auto& mapValues = splitedMapData[2];
+			ValueConverter<Type> converter;
+			if constexpr (CS::TypeHelper::IsMap<Type>::value)
+			{
+				converter.castElementInto(aElement, aIndex, valueOf(aObject), aSpare);
+			}
+			else
+			{
+				converter.castElementInto(aElement, aIndex, valueOf(aObject));
+			}
+		}
+	};
 
-			if (!mapType.empty() && !mapInnerType.empty() && !mapValues.empty())
+	void endElements(void* aObject, std::size_t aAmount, std::size_t aCount, bool aHasCount, std::shared_ptr<void>& aSpare) override
+	{
+		if constexpr (HasElements)
+		{
+			ValueConverter<Type> converter;
+			if constexpr (CS::TypeHelper::IsMap<Type>::value)
 			{
-				if (mapType == CSTypeDefines::csMapType)
-				{
-					auto [keyType, valueType] = CS::DataHelper::splitTwoValues(mapInnerType, CSTypeDefines::csContainerValuesDelimiter);
-					if (!keyConverter.typeOf(keyType))
-					{
-						CS::Errors::throwExceptionWithTypeMismatch(keyType, keyConverter.type());
-					}
-
-					if (!valueConverter.typeOf(valueType))
-					{
-						CS::Errors::throwExceptionWithTypeMismatch(valueType, valueConverter.type());
-					}
-
-					auto mapEntries = CS::DataHelper::splitString(mapValues, CSTypeDefines::csMapValueDelimiter);
-					for (const auto& keyValue : mapEntries)
-					{
-						const auto [key, value] = CS::DataHelper::splitTwoValues(keyValue, CSTypeDefines::csContainerValuesDelimiter);
-						map.emplace(keyConverter.cast(key), valueConverter.cast(value));
-					}
-				}
-				else
-				{
-					CS::Errors::throwExceptionWithTypeMismatch(mapType, CSTypeDefines::csMapType);
-				}
+				converter.endElements(aAmount, aCount, aHasCount, aSpare);
+			}
+			else
+			{
+				converter.endElements(aAmount, aCount, aHasCount, valueOf(aObject));
 			}
 		}
 	};
 
-	std::string asString() override
+	void setFramed(void* aObject, std::string_view& aValue) override
 	{
-		std::string string;
+		CS_FIELD_STATS_SCOPE(stats, aValue);
+		FramedField::castInto(aValue, valueOf(aObject));
+	};
 
-		ValueConverter<KeyType> keyConverter;
-		ValueConverter<ValueType> valueConverter;
+	void setUncheckedFramed(void* aObject, std::string_view& aValue) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aValue);
+		FramedField::castUncheckedInto(aValue, valueOf(aObject));
+	};
 
-		MapType& map = *valuePointer;
-		auto valuesAmount = map.size();
+	CSTypeDefines::DecodeStatus trySetFramed(void* aObject, std::string_view& aValue, bool aUnchecked) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aValue);
+		return countFailure(aUnchecked ? FramedField::tryCastUncheckedInto(aValue, valueOf(aObject)) : FramedField::tryCastInto(aValue, valueOf(aObject)));
+	};
 
-		auto keyType = keyConverter.type();
-		auto valueType = valueConverter.type();
+	void appendFramed(const void* aObject, std::string& aBuffer) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aBuffer);
+		FramedField::append(aBuffer, valueOf(aObject));
+	};
 
-		string += CS::TypeHelper::formatContainerTypes(CSTypeDefines::csMapType, {keyType, valueType});
+	std::size_t framedSize(const void* aObject) override
+	{
+		return FramedField::size(valueOf(aObject));
+	};
 
-		for (auto& [key, value] : map)
-		{
-			string += keyConverter.toString(key) + CSTypeDefines::csContainerValuesDelimiter + valueConverter.toString(value);
-			if (--valuesAmount != 0)
-			{
-				string += CSTypeDefines::csMapValueDelimiter;
-			}
-		}
+	void appendColumn(const void* aObjects, std::size_t aStride, std::size_t aAmount, std::string& aBuffer, CSTypeDefines::WireFormat aFormat) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aBuffer);
+		auto objects = static_cast<const char*>(aObjects);
+		ColumnValue<Type>::append(aBuffer, aAmount, [this, objects, aStride](std::size_t aIndex) -> const Type& { return valueOf(objects + aIndex * aStride); }, aFormat);
+	};
+
+	void setColumn(void* aObjects, std::size_t aStride, std::size_t aAmount, std::string_view aColumn, CSTypeDefines::WireFormat aFormat) override
+	{
+		CS_FIELD_STATS_SCOPE(stats, aColumn.size());
+		auto objects = static_cast<char*>(aObjects);
+		ColumnValue<Type>::castInto(aColumn, aAmount, [this, objects, aStride](std::size_t aIndex) -> Type& { return valueOf(objects + aIndex * aStride); }, aFormat);
+	};
+
+	bool equals(const void* aObject, const void* aOther) override
+	{
+		return valueOf(aObject) == valueOf(aOther);
+	};
+
+	void appendDelta(const void* aObject, const void* aPrevious, DeltaWriter& aWriter) override
+	{
+		ValueDelta<Type>::append(aWriter, valueOf(aObject), valueOf(aPrevious));
+	};
 
-		return string;;
+	void applyDelta(void* aObject, CSTypeDefines::DeltaOperation aOperation, DeltaReader& aReader) override
+	{
+		ValueDelta<Type>::apply(aReader, aOperation, valueOf(aObject));
 	};
 };
 
-#endif // !__CS_CONVERTABLE_VALUE_H__     
\ No newline at end of file
+#endif // !__CS_CONVERTABLE_VALUE_H__
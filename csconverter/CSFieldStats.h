@@ -0,0 +1,250 @@
+#ifndef __CS_FIELD_STATS_H__
+#define __CS_FIELD_STATS_H__
+
+#include "CSHelper.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+
+// Per field encode and decode counters of ConvertableStruct types. They are
+// compiled in only with CS_FIELD_STATS defined (CMake option
+// CSCONVERTER_FIELD_STATS), which has to be the same for every translation
+// unit; without it fields hold no counters and nothing is measured.
+//
+//	std::cout << record.fieldStats().text();
+//
+// Calls, bytes and time are counted around setValue, appendTo and their
+// binary, framed and column variants, asString through appendTo. Allocations
+// are counted when the program's operator new calls CS::Events::countAllocation().
+
+// Counters of one field at the time it was read.
+struct FieldStatsSnapshot
+{
+	std::string_view key;
+	std::uint64_t decodes = 0;
+	std::uint64_t encodes = 0;
+	std::uint64_t bytesConsumed = 0;
+	std::uint64_t bytesProduced = 0;
+	std::uint64_t decodeNanoseconds = 0;
+	std::uint64_t encodeNanoseconds = 0;
+	std::uint64_t allocations = 0;
+	std::uint64_t typeMismatches = 0;
+	// Calls that threw, type mismatches included.
+	std::uint64_t errors = 0;
+};
+
+// Counters of one field, shared by every thread using its struct type.
+struct FieldStats
+{
+	std::atomic<std::uint64_t> decodes{ 0 };
+	std::atomic<std::uint64_t> encodes{ 0 };
+	std::atomic<std::uint64_t> bytesConsumed{ 0 };
+	std::atomic<std::uint64_t> bytesProduced{ 0 };
+	std::atomic<std::uint64_t> decodeNanoseconds{ 0 };
+	std::atomic<std::uint64_t> encodeNanoseconds{ 0 };
+	std::atomic<std::uint64_t> allocations{ 0 };
+	std::atomic<std::uint64_t> typeMismatches{ 0 };
+	std::atomic<std::uint64_t> errors{ 0 };
+
+	FieldStatsSnapshot snapshot(std::string_view aKey) const
+	{
+		auto load = [](const std::atomic<std::uint64_t>& aCounter) { return aCounter.load(std::memory_order_relaxed); };
+
+		return FieldStatsSnapshot{ aKey, load(decodes), load(encodes), load(bytesConsumed), load(bytesProduced),
+			load(decodeNanoseconds), load(encodeNanoseconds), load(allocations), load(typeMismatches), load(errors) };
+	}
+
+	void reset()
+	{
+		for (auto* counter : { &decodes, &encodes, &bytesConsumed, &bytesProduced, &decodeNanoseconds, &encodeNanoseconds, &allocations, &typeMismatches, &errors })
+		{
+			counter->store(0, std::memory_order_relaxed);
+		}
+	}
+};
+
+// Measures one field call from construction to destruction, a call left
+// by an exception counts as an error.
+struct FieldStatsScope
+{
+public:
+	// Decoding aBytes of input.
+	FieldStatsScope(FieldStats& aStats, std::size_t aBytes)
+		: stats{ aStats }, decoding{ true }, bytes{ aBytes } {}
+
+	// Decoding from the front of aData, which the call consumes.
+	FieldStatsScope(FieldStats& aStats, const std::string_view& aData)
+		: stats{ aStats }, decoding{ true }, data{ &aData }, dataSize{ aData.size() } {}
+
+	// Encoding to the end of aBuffer.
+	FieldStatsScope(FieldStats& aStats, const std::string& aBuffer)
+		: stats{ aStats }, decoding{ false }, buffer{ &aBuffer }, bufferSize{ aBuffer.size() } {}
+
+	FieldStatsScope(const FieldStatsScope&) = delete;
+	FieldStatsScope& operator=(const FieldStatsScope&) = delete;
+
+	~FieldStatsScope()
+	{
+		auto nanoseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+		if (data)
+		{
+			bytes = dataSize - data->size();
+		}
+		else if (buffer)
+		{
+			bytes = buffer->size() - bufferSize;
+		}
+
+		add(decoding ? stats.decodes : stats.encodes, 1);
+		add(decoding ? stats.bytesConsumed : stats.bytesProduced, bytes);
+		add(decoding ? stats.decodeNanoseconds : stats.encodeNanoseconds, nanoseconds);
+		add(stats.allocations, CS::Events::allocations - allocations);
+		add(stats.typeMismatches, CS::Events::typeMismatches - typeMismatches);
+		add(stats.errors, std::uncaught_exceptions() > exceptions ? 1 : 0);
+	}
+
+private:
+	FieldStats& stats;
+	bool decoding;
+	std::size_t bytes = 0;
+	const std::string_view* data = nullptr;
+	std::size_t dataSize = 0;
+	const std::string* buffer = nullptr;
+	std::size_t bufferSize = 0;
+
+	std::uint64_t allocations = CS::Events::allocations;
+	std::uint64_t typeMismatches = CS::Events::typeMismatches;
+	int exceptions = std::uncaught_exceptions();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	static void add(std::atomic<std::uint64_t>& aCounter, std::uint64_t aAmount)
+	{
+		if (aAmount != 0)
+		{
+			aCounter.fetch_add(aAmount, std::memory_order_relaxed);
+		}
+	}
+};
+
+#if defined(CS_FIELD_STATS)
+#define CS_FIELD_STATS_SCOPE(...) FieldStatsScope fieldStatsScope(__VA_ARGS__)
+#else
+#define CS_FIELD_STATS_SCOPE(...)
+#endif
+
+// Counters of every field of a struct type, in key order.
+struct FieldStatsReport
+{
+	std::vector<FieldStatsSnapshot> fields;
+
+	// One line per field with its share of the decode and encode time.
+	std::string text() const
+	{
+		std::string string = "field                    decodes   bytes in   decode ms  decode %   encodes  bytes out   encode ms  encode %    allocs  mismatches    errors\n";
+
+		auto total = totals();
+		for (auto& field : fields)
+		{
+			char line[256];
+			std::snprintf(line, sizeof(line), "%-20.*s %11llu %10llu %11.3f %8.1f%% %9llu %10llu %11.3f %8.1f%% %9llu %11llu %9llu\n",
+				static_cast<int>(std::min<std::size_t>(field.key.size(), 20)), field.key.data(),
+				count(field.decodes), count(field.bytesConsumed), milliseconds(field.decodeNanoseconds), share(field.decodeNanoseconds, total.decodeNanoseconds),
+				count(field.encodes), count(field.bytesProduced), milliseconds(field.encodeNanoseconds), share(field.encodeNanoseconds, total.encodeNanoseconds),
+				count(field.allocations), count(field.typeMismatches), count(field.errors));
+			string += line;
+		}
+
+		return string;
+	}
+
+	// [{"key":"value","decodes":1,...},...], times in nanoseconds.
+	std::string json() const
+	{
+		std::string string = "[";
+		for (auto& field : fields)
+		{
+			if (&field != &fields.front())
+			{
+				string += ',';
+			}
+
+			string += "{\"key\":\"";
+			appendEscaped(string, field.key);
+			string += '"';
+
+			appendMember(string, "decodes", field.decodes);
+			appendMember(string, "encodes", field.encodes);
+			appendMember(string, "bytesConsumed", field.bytesConsumed);
+			appendMember(string, "bytesProduced", field.bytesProduced);
+			appendMember(string, "decodeNanoseconds", field.decodeNanoseconds);
+			appendMember(string, "encodeNanoseconds", field.encodeNanoseconds);
+			appendMember(string, "allocations", field.allocations);
+			appendMember(string, "typeMismatches", field.typeMismatches);
+			appendMember(string, "errors", field.errors);
+			string += '}';
+		}
+
+		string += ']';
+		return string;
+	}
+
+	// Sums of every field, with an empty key.
+	FieldStatsSnapshot totals() const
+	{
+		FieldStatsSnapshot total;
+		for (auto& field : fields)
+		{
+			total.decodes += field.decodes;
+			total.encodes += field.encodes;
+			total.bytesConsumed += field.bytesConsumed;
+			total.bytesProduced += field.bytesProduced;
+			total.decodeNanoseconds += field.decodeNanoseconds;
+			total.encodeNanoseconds += field.encodeNanoseconds;
+			total.allocations += field.allocations;
+			total.typeMismatches += field.typeMismatches;
+			total.errors += field.errors;
+		}
+
+		return total;
+	}
+
+private:
+	static unsigned long long count(std::uint64_t aValue) { return static_cast<unsigned long long>(aValue); }
+	static double milliseconds(std::uint64_t aNanoseconds) { return static_cast<double>(aNanoseconds) / 1e6; }
+	static double share(std::uint64_t aPart, std::uint64_t aTotal) { return aTotal == 0 ? 0.0 : 100.0 * static_cast<double>(aPart) / static_cast<double>(aTotal); }
+
+	static void appendMember(std::string& aBuffer, std::string_view aName, std::uint64_t aValue)
+	{
+		aBuffer += ",\"";
+		aBuffer += aName;
+		aBuffer += "\":";
+		aBuffer += std::to_string(aValue);
+	}
+
+	static void appendEscaped(std::string& aBuffer, std::string_view aValue)
+	{
+		for (char character : aValue)
+		{
+			if (character == '"' || character == '\\')
+			{
+				aBuffer += '\\';
+				aBuffer += character;
+			}
+			else if (static_cast<unsigned char>(character) < 0x20)
+			{
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(character));
+				aBuffer += escaped;
+			}
+			else
+			{
+				aBuffer += character;
+			}
+		}
+	}
+};
+
+#endif // !__CS_FIELD_STATS_H__
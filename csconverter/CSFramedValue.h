@@ -0,0 +1,374 @@
+#ifndef __CS_FRAMED_VALUE_H__
+#define __CS_FRAMED_VALUE_H__
+
+#include "CSValueConverter.h"
+
+// Framed format values. Every value is a frame, "<length>:<payload>", and
+// fields keep the typed text header in front of theirs:
+//
+//	s$5:hello|i$2:10|v$s$10:5:hello1:a|m$s^i$8:2:k12:10
+//
+// Scalars and strings carry their text form, strings as raw bytes.
+// Containers carry the frames of their elements, maps key then value, so
+// no delimiter is ever searched for and a value is skipped by its length.
+
+// Scalars and strings.
+template<typename Type, typename TypeDefinition = void>
+struct FramedValue
+{
+	static CSTypeDefines::DecodeStatus tryCheckTypes(std::string_view aType, std::string_view aInnerTypes)
+	{
+		ValueConverter<Type> converter;
+		return converter.typeOf(aType) && aInnerTypes.empty() ? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::TypeMismatch;
+	}
+
+	static void append(std::string& aBuffer, const Type& aValue)
+	{
+		ValueConverter<Type> converter;
+		auto payloadStart = aBuffer.size();
+		converter.appendString(aBuffer, aValue);
+		CS::FramingHelper::insertFrameLength(aBuffer, payloadStart);
+	}
+
+	static std::size_t size(const Type& aValue)
+	{
+		ValueConverter<Type> converter;
+		auto payloadSize = converter.stringSize(aValue);
+		return CS::FramingHelper::frameLengthSize(payloadSize) + payloadSize;
+	}
+
+	static void castInto(std::string_view& aData, Type& aValue) { CS::Errors::throwExceptionWithStatus(tryCastInto(aData, aValue), {}, ValueConverter<Type>().type()); }
+
+	static CSTypeDefines::DecodeStatus tryCastInto(std::string_view& aData, Type& aValue)
+	{
+		std::string_view payload;
+		if (!CS::FramingHelper::tryReadFrame(aData, payload))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedFrame;
+		}
+
+		ValueConverter<Type> converter;
+		return converter.tryCastInto(payload, aValue);
+	}
+};
+
+// @ VECTOR FRAMES @
+
+// Vectors and arrays, arrays have to get exactly their size of elements.
+template<typename VectorType>
+struct FramedValue<VectorType, CS::TypeHelper::isSequence<VectorType>>
+{
+	using ValueType = typename VectorType::value_type;
+
+	static CSTypeDefines::DecodeStatus tryCheckTypes(std::string_view aType, std::string_view aInnerTypes)
+	{
+		ValueConverter<VectorType> converter;
+		ValueConverter<ValueType> valueConverter;
+		return converter.typeOf(aType) && valueConverter.typeOf(aInnerTypes) ? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::TypeMismatch;
+	}
+
+	static void append(std::string& aBuffer, const VectorType& aValue)
+	{
+		auto payloadStart = aBuffer.size();
+		for (auto& value : aValue)
+		{
+			FramedValue<ValueType>::append(aBuffer, value);
+		}
+
+		CS::FramingHelper::insertFrameLength(aBuffer, payloadStart);
+	}
+
+	static std::size_t size(const VectorType& aValue)
+	{
+		auto size = payloadSize(aValue);
+		return CS::FramingHelper::frameLengthSize(size) + size;
+	}
+
+	static void castInto(std::string_view& aData, VectorType& aVector) { CS::Errors::throwExceptionWithStatus(tryCastInto(aData, aVector), {}, ValueConverter<VectorType>().type()); }
+
+	// Decodes over the existing elements like ValueConverter::castInto.
+	static CSTypeDefines::DecodeStatus tryCastInto(std::string_view& aData, VectorType& aVector)
+	{
+		std::string_view payload;
+		if (!CS::FramingHelper::tryReadFrame(aData, payload))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedFrame;
+		}
+
+		if constexpr (CS::TypeHelper::IsArray<VectorType>::value)
+		{
+			for (auto& value : aVector)
+			{
+				if (payload.empty())
+				{
+					return CSTypeDefines::DecodeStatus::MalformedFrame;
+				}
+
+				auto status = FramedValue<ValueType>::tryCastInto(payload, value);
+				if (status != CSTypeDefines::DecodeStatus::Ok)
+				{
+					return status;
+				}
+			}
+
+			return payload.empty() ? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::MalformedFrame;
+		}
+		else
+		{
+			std::size_t valuesAmount = 0;
+			for (; !payload.empty(); ++valuesAmount)
+			{
+				auto status = CSTypeDefines::DecodeStatus::Ok;
+				if (valuesAmount < aVector.size())
+				{
+					status = FramedValue<ValueType>::tryCastInto(payload, aVector[valuesAmount]);
+				}
+				else
+				{
+					auto element = CS::TypeHelper::makeWithAllocator<ValueType>(aVector.get_allocator());
+					status = FramedValue<ValueType>::tryCastInto(payload, element);
+					if (status == CSTypeDefines::DecodeStatus::Ok)
+					{
+						aVector.push_back(std::move(element));
+					}
+				}
+
+				if (status != CSTypeDefines::DecodeStatus::Ok)
+				{
+					return status;
+				}
+			}
+
+			aVector.erase(aVector.begin() + static_cast<std::ptrdiff_t>(valuesAmount), aVector.end());
+			return CSTypeDefines::DecodeStatus::Ok;
+		}
+	}
+
+private:
+	static std::size_t payloadSize(const VectorType& aValue)
+	{
+		std::size_t size = 0;
+		for (auto& value : aValue)
+		{
+			size += FramedValue<ValueType>::size(value);
+		}
+
+		return size;
+	}
+};
+
+// @ PAIR FRAMES @
+
+template<typename PairType>
+struct FramedValue<PairType, CS::TypeHelper::isPair<PairType>>
+{
+	using FirstType = typename PairType::first_type;
+	using SecondType = typename PairType::second_type;
+
+	static CSTypeDefines::DecodeStatus tryCheckTypes(std::string_view aType, std::string_view aInnerTypes)
+	{
+		ValueConverter<PairType> converter;
+		ValueConverter<FirstType> firstValueConverter;
+		ValueConverter<SecondType> secondValueConverter;
+
+		auto [firstType, secondType] = CS::DataHelper::splitTwoValues(aInnerTypes, CSTypeDefines::csContainerValuesDelimiter);
+		return converter.typeOf(aType) && firstValueConverter.typeOf(firstType) && secondValueConverter.typeOf(secondType) 
+			? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::TypeMismatch;
+	}
+
+	static void append(std::string& aBuffer, const PairType& aValue)
+	{
+		auto payloadStart = aBuffer.size();
+		FramedValue<FirstType>::append(aBuffer, aValue.first);
+		FramedValue<SecondType>::append(aBuffer, aValue.second);
+		CS::FramingHelper::insertFrameLength(aBuffer, payloadStart);
+	}
+
+	static std::size_t size(const PairType& aValue)
+	{
+		auto size = payloadSize(aValue);
+		return CS::FramingHelper::frameLengthSize(size) + size;
+	}
+
+	static void castInto(std::string_view& aData, PairType& aPair) { CS::Errors::throwExceptionWithStatus(tryCastInto(aData, aPair), {}, ValueConverter<PairType>().type()); }
+
+	static CSTypeDefines::DecodeStatus tryCastInto(std::string_view& aData, PairType& aPair)
+	{
+		std::string_view payload;
+		if (!CS::FramingHelper::tryReadFrame(aData, payload))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedFrame;
+		}
+
+		auto status = FramedValue<FirstType>::tryCastInto(payload, aPair.first);
+		if (status == CSTypeDefines::DecodeStatus::Ok)
+		{
+			status = FramedValue<SecondType>::tryCastInto(payload, aPair.second);
+		}
+
+		if (status == CSTypeDefines::DecodeStatus::Ok && !payload.empty())
+		{
+			return CSTypeDefines::DecodeStatus::MalformedFrame;
+		}
+
+		return status;
+	}
+
+private:
+	static std::size_t payloadSize(const PairType& aValue)
+	{
+		return FramedValue<FirstType>::size(aValue.first) + FramedValue<SecondType>::size(aValue.second);
+	}
+};
+
+// @ MAP FRAMES @
+
+template<typename MapType>
+struct FramedValue<MapType, CS::TypeHelper::isMap<MapType>>
+{
+	using KeyType = typename MapType::key_type;
+	using ValueType = typename MapType::mapped_type;
+
+	static CSTypeDefines::DecodeStatus tryCheckTypes(std::string_view aType, std::string_view aInnerTypes)
+	{
+		ValueConverter<MapType> converter;
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		auto [keyType, valueType] = CS::DataHelper::splitTwoValues(aInnerTypes, CSTypeDefines::csContainerValuesDelimiter);
+		return converter.typeOf(aType) && keyConverter.typeOf(keyType) && valueConverter.typeOf(valueType) 
+			? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::TypeMismatch;
+	}
+
+	static void append(std::string& aBuffer, const MapType& aValue)
+	{
+		auto payloadStart = aBuffer.size();
+		for (auto& [key, value] : aValue)
+		{
+			FramedValue<KeyType>::append(aBuffer, key);
+			FramedValue<ValueType>::append(aBuffer, value);
+		}
+
+		CS::FramingHelper::insertFrameLength(aBuffer, payloadStart);
+	}
+
+	static std::size_t size(const MapType& aValue)
+	{
+		auto size = payloadSize(aValue);
+		return CS::FramingHelper::frameLengthSize(size) + size;
+	}
+
+	static void castInto(std::string_view& aData, MapType& aMap) { CS::Errors::throwExceptionWithStatus(tryCastInto(aData, aMap), {}, ValueConverter<MapType>().type()); }
+
+	// Replaces the entries and reuses the old nodes like ValueConverter::castInto.
+	static CSTypeDefines::DecodeStatus tryCastInto(std::string_view& aData, MapType& aMap)
+	{
+		std::string_view payload;
+		if (!CS::FramingHelper::tryReadFrame(aData, payload))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedFrame;
+		}
+
+		typename ValueConverter<MapType>::RecycledNodes nodes(aMap);
+		while (!payload.empty())
+		{
+			auto status = nodes.insert([&payload](KeyType& aKey) { return FramedValue<KeyType>::tryCastInto(payload, aKey); },
+				[&payload](ValueType& aMapped) { return FramedValue<ValueType>::tryCastInto(payload, aMapped); });
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+		}
+
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+private:
+	static std::size_t payloadSize(const MapType& aValue)
+	{
+		std::size_t size = 0;
+		for (auto& [key, value] : aValue)
+		{
+			size += FramedValue<KeyType>::size(key) + FramedValue<ValueType>::size(value);
+		}
+
+		return size;
+	}
+};
+
+// @ FRAMED FIELD @
+
+// Type header followed by the frame, the form of fields and delta payloads.
+struct FramedField
+{
+	template<typename Type>
+	static void append(std::string& aBuffer, const Type& aValue)
+	{
+		aBuffer += ValueConverter<Type>::signature();
+		FramedValue<Type>::append(aBuffer, aValue);
+	}
+
+	template<typename Type>
+	static std::size_t size(const Type& aValue) { return ValueConverter<Type>::signature().size() + FramedValue<Type>::size(aValue); }
+
+	template<typename Type>
+	static void castInto(std::string_view& aData, Type& aValue)
+	{
+		auto field = aData;
+		auto status = tryCastInto(aData, aValue);
+		if (status != CSTypeDefines::DecodeStatus::Ok)
+		{
+			CS::Errors::throwExceptionWithStatus(status, field.substr(0, field.find(CSTypeDefines::csValueDelimiter)), ValueConverter<Type>().type());
+		}
+	}
+
+	template<typename Type>
+	static void castUncheckedInto(std::string_view& aData, Type& aValue)
+	{
+		auto field = aData;
+		auto status = tryCastUncheckedInto(aData, aValue);
+		if (status != CSTypeDefines::DecodeStatus::Ok)
+		{
+			CS::Errors::throwExceptionWithStatus(status, field.substr(0, field.find(CSTypeDefines::csValueDelimiter)), ValueConverter<Type>().type());
+		}
+	}
+
+	// Non-throwing casts, the ones above throw what these return.
+	template<typename Type>
+	static CSTypeDefines::DecodeStatus tryCastInto(std::string_view& aData, Type& aValue)
+	{
+		constexpr auto signature = ValueConverter<Type>::signature();
+		if (aData.substr(0, signature.size()) == signature)
+		{
+			aData.remove_prefix(signature.size());
+		}
+		else
+		{
+			// A mismatch, or a malformed frame when there is no header.
+			std::string_view type;
+			std::string_view innerTypes;
+			if (!CS::FramingHelper::tryReadTypeHeader(aData, type, innerTypes))
+			{
+				return CSTypeDefines::DecodeStatus::MalformedFrame;
+			}
+
+			auto status = FramedValue<Type>::tryCheckTypes(type, innerTypes);
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+		}
+
+		return FramedValue<Type>::tryCastInto(aData, aValue);
+	}
+
+	// Skips the type header without looking at it, the frames are still checked.
+	template<typename Type>
+	static CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view& aData, Type& aValue)
+	{
+		aData = CS::TypeHelper::skipSignature(aData, ValueConverter<Type>::signature());
+		return FramedValue<Type>::tryCastInto(aData, aValue);
+	}
+};
+
+#endif // !__CS_FRAMED_VALUE_H__
@@ -2,28 +2,99 @@
 #define _CS_HELPER_H__
 
 #include <type_traits>
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <array>
+#include <iterator>
 #include <map>
 #include <unordered_map>
 #include <vector>
 #include <sstream>
+#include <initializer_list>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <memory>
+#include <charconv>
 
 namespace CSTypeDefines
 {
-    const std::string csStringType = "s";
-    const std::string csIntegralType = "i";
-    const std::string csFloatingType = "f";
-    const std::string csMapType = "m";
-    const std::string csBoolType = "b";
-    const std::string csVectorType = "v";
-    const std::string csPairType = "p";
-
-    const std::string csTypeDelimiter = "$";
+    // Every type is one byte on the wire. The converters build their type
+    // signatures from these at compile time.
+    constexpr char csStringTag = 's';
+    constexpr char csIntegralTag = 'i';
+    constexpr char csFloatingTag = 'f';
+    constexpr char csMapTag = 'm';
+    constexpr char csBoolTag = 'b';
+    constexpr char csVectorTag = 'v';
+    constexpr char csPairTag = 'p';
+
+    constexpr char csTypeDelimiterTag = '$';
+    constexpr char csContainerValuesDelimiterTag = '^';
+
+    const std::string csStringType{ csStringTag };
+    const std::string csIntegralType{ csIntegralTag };
+    const std::string csFloatingType{ csFloatingTag };
+    const std::string csMapType{ csMapTag };
+    const std::string csBoolType{ csBoolTag };
+    const std::string csVectorType{ csVectorTag };
+    const std::string csPairType{ csPairTag };
+
+    const std::string csTypeDelimiter{ csTypeDelimiterTag };
     const std::string csValueDelimiter = "|";
 
-    const std::string csContainerValuesDelimiter = "^";
+    const std::string csContainerValuesDelimiter{ csContainerValuesDelimiterTag };
 
     const std::string csMapValueDelimiter = "#";
+
+    // Ends the length prefix of a framed value, "5:hello".
+    const std::string csFrameLengthDelimiter = ":";
+
+    // Separates records in line save files and streams.
+    const std::string csRecordDelimiter = "\n";
+
+    // Starts a stream header line with the schema fingerprint of the records
+    // after it, "!<16 hex digits>". Typed fields never start with it.
+    const std::string csFingerprintMarker = "!";
+
+    // Text is the readable "|"/"$" line save. Binary drops the type tags and
+    // writes varints, raw little-endian floats and length/count prefixes;
+    // vectors and arrays of numbers are one raw little-endian block.
+    // Framed is Text with a decimal length before every value and no
+    // delimiters inside containers, so values may hold any bytes.
+    enum class WireFormat
+    {
+        Text,
+        Binary,
+        Framed
+    };
+
+    // Change kind of a delta entry, written as the character after the field index.
+    // Replace carries the whole value. Insert appends to a vector or upserts map
+    // entries, Remove truncates a vector or erases map keys.
+    enum class DeltaOperation : char
+    {
+        Replace = '=',
+        Insert = '+',
+        Remove = '-'
+    };
+
+    // Why a non-throwing decode failed, one per kind of CS::Errors decode error.
+    enum class DecodeStatus : char
+    {
+        Ok,
+        TypeMismatch,
+        FailedToParse,
+        MalformedBinary,
+        MalformedFrame,
+        MalformedColumn,
+        MalformedHeader,
+        MalformedDelta,
+        CountOverLimit,
+        TokenOverLimit
+    };
 };
 
 struct CS
@@ -36,8 +107,9 @@ struct CS
         template<typename T>
         using isArithmetic = typename std::enable_if_t<std::is_arithmetic<T>::value>;
 
+        // bool is integral too, but has its own "+"/"-" converter.
         template<typename T>
-        using isIntergal = typename std::enable_if_t<std::is_integral<T>::value>;
+        using isIntergal = typename std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>;
 
         template<typename T>
         using isFloating = typename std::enable_if_t<std::is_floating_point<T>::value>;
@@ -45,14 +117,80 @@ struct CS
         template<typename A, typename B>
         using isSame = typename std::enable_if_t<std::is_same<A, B>::value>;
 
+        // Containers match with any allocator, so std::pmr types use the same converters.
+        template<typename T>
+        struct IsString : std::false_type {};
+
+        template<typename Allocator>
+        struct IsString<std::basic_string<char, std::char_traits<char>, Allocator>> : std::true_type {};
+
+        template<typename T>
+        struct IsVector : std::false_type {};
+
+        template<typename T, typename Allocator>
+        struct IsVector<std::vector<T, Allocator>> : std::true_type {};
+
+        template<typename T>
+        struct IsMap : std::false_type {};
+
+        template<typename T>
+        struct IsArray : std::false_type {};
+
+        template<typename T, std::size_t Size>
+        struct IsArray<std::array<T, Size>> : std::true_type {};
+
+        template<typename Key, typename T, typename Compare, typename Allocator>
+        struct IsMap<std::map<Key, T, Compare, Allocator>> : std::true_type {};
+
+        template<typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+        struct IsMap<std::unordered_map<Key, T, Hash, KeyEqual, Allocator>> : std::true_type {};
+
         template<typename T>
-        using isMap = typename std::enable_if_t<std::_Is_any_of_v<T, std::map<typename T::key_type, typename T::mapped_type>, 
-            std::unordered_map<typename T::key_type, typename T::mapped_type>>>;
+        using isString = typename std::enable_if_t<IsString<T>::value>;
+
+        template<typename T>
+        using isVector = typename std::enable_if_t<IsVector<T>::value>;
+
+        template<typename T>
+        using isArray = typename std::enable_if_t<IsArray<T>::value>;
+
+        // Vectors and arrays, which share the "v$" form.
+        template<typename T>
+        using isSequence = typename std::enable_if_t<IsVector<T>::value || IsArray<T>::value>;
+
+        template<typename T>
+        using isMap = typename std::enable_if_t<IsMap<T>::value>;
+
+        // Numbers that vectors and arrays write as one run, see PackedNumbers.
+        template<typename T>
+        struct IsPackedNumber : std::bool_constant<std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && sizeof(T) <= sizeof(std::uint64_t)> {};
+
+        // A default constructed value that allocates through aAllocator when it
+        // is allocator aware, e.g. a std::pmr::string key of a std::pmr::map.
+        template<typename T, typename Allocator>
+        static T makeWithAllocator(const Allocator& aAllocator)
+        {
+            if constexpr (std::uses_allocator_v<T, Allocator>)
+            {
+                return T(typename T::allocator_type(aAllocator));
+            }
+            else
+            {
+                return T{};
+            }
+        }
+
+        // Containers that can be pre-sized, e.g. std::unordered_map but not std::map.
+        template<typename T, typename = void>
+        struct HasReserve : std::false_type {};
+
+        template<typename T>
+        struct HasReserve<T, std::void_t<decltype(std::declval<T&>().reserve(std::size_t{}))>> : std::true_type {};
 
         template<typename T>
         using isPair = isSame<T, std::pair<typename T::first_type, typename T::second_type>>;
 
-        static std::string tryGetFullType(const std::string& aShortType)
+        static std::string tryGetFullType(std::string_view aShortType)
         {
             if (aShortType == CSTypeDefines::csStringType)
             {
@@ -78,6 +216,10 @@ struct CS
             {
                 return "Vector";
             }
+            else if (aShortType == CSTypeDefines::csPairType)
+            {
+                return "Pair";
+            }
             else
             {
                 return "Undefined";
@@ -86,106 +228,900 @@ struct CS
             return "Undefined";
         }
 
-        static std::string typifyValue(const std::string& aType, std::string&& aValue)
+        // Type header of a value: "i$" for a scalar, "v$i$" or "m$s^i$" with
+        // the tags of the elements for a container.
+        template<char Tag, char... InnerTags>
+        static constexpr auto makeSignature()
         {
-            std::string typifyedValue;
-            typifyedValue += aType;
-            typifyedValue += CSTypeDefines::csTypeDelimiter;
-            typifyedValue += std::move<>(aValue);
+            std::array<char, sizeof...(InnerTags) == 0 ? 2 : 2 * sizeof...(InnerTags) + 2> signature{};
+            std::size_t size = 0;
 
-            return typifyedValue;
+            signature[size++] = Tag;
+            signature[size++] = CSTypeDefines::csTypeDelimiterTag;
+            if constexpr (sizeof...(InnerTags) != 0)
+            {
+                for (char innerTag : { InnerTags... })
+                {
+                    signature[size++] = innerTag;
+                    signature[size++] = CSTypeDefines::csContainerValuesDelimiterTag;
+                }
+
+                signature[size - 1] = CSTypeDefines::csTypeDelimiterTag;
+            }
+
+            return signature;
+        }
+
+        template<char Tag, char... InnerTags>
+        struct Signature
+        {
+            static constexpr auto chars = makeSignature<Tag, InnerTags...>();
+
+            static constexpr std::string_view view() { return { chars.data(), chars.size() }; }
+        };
+
+        // The value behind aSignature. A value of another type throws a type
+        // mismatch naming its own type.
+        static std::string_view stripSignature(std::string_view aValue, std::string_view aSignature)
+        {
+            if (!hasSignature(aValue, aSignature))
+            {
+                CS::Errors::throwExceptionWithTypeMismatch(aValue.substr(0, aValue.find(CSTypeDefines::csTypeDelimiter)), aSignature.substr(0, 1));
+            }
+
+            return aValue.substr(aSignature.size());
+        }
+
+        static bool hasSignature(std::string_view aValue, std::string_view aSignature) { return aValue.substr(0, aSignature.size()) == aSignature; }
+
+        // The value behind aSignature when its type is already known to match,
+        // e.g. through the schema fingerprint. Nothing is compared.
+        static std::string_view skipSignature(std::string_view aValue, std::string_view aSignature)
+        {
+            aValue.remove_prefix(std::min(aSignature.size(), aValue.size()));
+            return aValue;
         }
 
-        static std::string typifyValue(std::string&& aType, std::string&& aValue)
+        // Schema fingerprint: 64-bit FNV-1a over the key and signature of every
+        // field in key order. ConvertableSchema and StaticConvertableStruct fold
+        // their fields the same way, so both kinds of struct agree on it.
+        static constexpr std::uint64_t FingerprintSeed = 14695981039346656037ull;
+
+        static constexpr std::uint64_t fingerprintField(std::uint64_t aFingerprint, std::string_view aKey, std::string_view aSignature)
+        {
+            return fingerprintBytes(fingerprintBytes(aFingerprint, aKey), aSignature);
+        }
+
+        // Element count after the container types of a text value, "v$s$3$a^b^c".
+        static void appendContainerCount(std::string& aBuffer, std::size_t aCount)
+        {
+            char digits[std::numeric_limits<std::size_t>::digits10 + 1];
+            auto [end, error] = std::to_chars(digits, digits + sizeof(digits), aCount);
+            aBuffer.append(digits, end);
+            aBuffer += CSTypeDefines::csTypeDelimiter;
+        }
+
+        static std::size_t containerCountSize(std::size_t aCount)
         {
-            std::string typifyedValue;
-            typifyedValue += std::move(aType);
-            typifyedValue += CSTypeDefines::csTypeDelimiter;
-            typifyedValue += std::move(aValue);
+            std::size_t size = 1;
+            while (aCount >= 10)
+            {
+                aCount /= 10;
+                ++size;
+            }
 
-            return typifyedValue;
+            return size + CSTypeDefines::csTypeDelimiter.size();
         }
 
-        static std::string formatType(std::vector<std::string>&& aTypes)
+    private:
+        // Every part ends with a zero byte, so "ab" + "c" and "a" + "bc" differ.
+        static constexpr std::uint64_t fingerprintBytes(std::uint64_t aFingerprint, std::string_view aBytes)
         {
-            std::string formatedType;
-            auto typesCount = aTypes.size();
-            for (auto& type : aTypes)
+            constexpr std::uint64_t prime = 1099511628211ull;
+            for (char byte : aBytes)
             {
-                formatedType += std::move(type);
-                if (--typesCount != 0)
+                aFingerprint = (aFingerprint ^ static_cast<unsigned char>(byte)) * prime;
+            }
+
+            return aFingerprint * prime;
+        }
+    };
+
+    struct DataHelper
+    {
+        // Lazy, non-owning split of a string view by a delimiter. Yields the same
+        // tokens as splitString (including empty ones) without copying them.
+        class SplitView
+        {
+        public:
+            class iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = std::string_view;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const std::string_view*;
+                using reference = const std::string_view&;
+
+                iterator() = default;
+
+                iterator(std::string_view aSource, std::string_view aDelimiter)
+                    : source{ aSource }, delimiter{ aDelimiter }, tokenStart{ 0 }
+                {
+                    tokenEnd = find(0);
+                    token = source.substr(0, tokenEnd);
+                }
+
+                reference operator*() const { return token; }
+                pointer operator->() const { return &token; }
+
+                iterator& operator++()
+                {
+                    if (tokenEnd == std::string_view::npos)
+                    {
+                        tokenStart = std::string_view::npos;
+                        token = {};
+                    }
+                    else
+                    {
+                        tokenStart = tokenEnd + delimiter.length();
+                        tokenEnd = find(tokenStart);
+                        token = tokenEnd == std::string_view::npos 
+                            ? source.substr(tokenStart) 
+                            : source.substr(tokenStart, tokenEnd - tokenStart);
+                    }
+
+                    return *this;
+                }
+
+                iterator operator++(int)
                 {
-                    formatedType += CSTypeDefines::csTypeDelimiter;
+                    iterator previous = *this;
+                    ++(*this);
+                    return previous;
                 }
+
+                bool operator==(const iterator& aOther) const { return tokenStart == aOther.tokenStart; }
+                bool operator!=(const iterator& aOther) const { return tokenStart != aOther.tokenStart; }
+
+                // Current token and everything after it.
+                std::string_view remainder() const 
+                { 
+                    return tokenStart == std::string_view::npos ? std::string_view{} : source.substr(tokenStart); 
+                }
+
+            private:
+                // Every delimiter of the format is one character, finding that
+                // character is cheaper than matching a substring.
+                std::string_view::size_type find(std::string_view::size_type aPosition) const
+                {
+                    return delimiter.length() == 1 ? source.find(delimiter[0], aPosition) : source.find(delimiter, aPosition);
+                }
+
+                std::string_view source;
+                std::string_view delimiter;
+                std::string_view token;
+                std::string_view::size_type tokenStart = std::string_view::npos;
+                std::string_view::size_type tokenEnd = std::string_view::npos;
+            };
+
+            SplitView(std::string_view aSource, std::string_view aDelimiter) 
+                : source{ aSource }, delimiter{ aDelimiter } {}
+
+            iterator begin() const { return iterator(source, delimiter); }
+            iterator end() const { return iterator(); }
+
+        private:
+            std::string_view source;
+            std::string_view delimiter;
+        };
+
+        static SplitView split(std::string_view aStr, std::string_view aDelimiter)
+        {
+            return SplitView(aStr, aDelimiter);
+        }
+
+        static std::vector<std::string> splitString(std::string_view str, std::string_view delimiter) 
+        {
+            std::vector<std::string> result;
+            for (auto token : split(str, delimiter))
+            {
+                result.emplace_back(token);
+            }
+
+            return result;
+        }
+
+        // Splits into exactly Count views. Returns false when the amount of tokens differs.
+        template<std::size_t Count>
+        static bool splitValues(std::string_view aStr, std::string_view aDelimiter, std::array<std::string_view, Count>& aValues)
+        {
+            std::size_t index = 0;
+            for (auto token : split(aStr, aDelimiter))
+            {
+                if (index == Count)
+                {
+                    return false;
+                }
+                aValues[index++] = token;
+            }
+
+            return index == Count;
+        }
+
+        static std::pair<std::string_view, std::string_view> splitTwoValues(std::string_view aStr, std::string_view aDelimiter)
+        {
+            std::array<std::string_view, 2> splited;
+            if (splitValues(aStr, aDelimiter, splited))
+            {
+                return { splited[0], splited[1] };
             }
 
-            return formatedType;
+            return {"", ""};
         }
 
-        static std::string formatContainerTypes(const std::string& aType, std::vector<std::string>&& aInnerTypes)
+        // Parts of a typed text container, "type$inner$count$values". Lines
+        // written before counts were added have no count part and still read.
+        struct ContainerParts
         {
-            std::string innerTyeps;
-            innerTyeps += aType;
-            innerTyeps += CSTypeDefines::csTypeDelimiter;
+            std::string_view type;
+            std::string_view innerTypes;
+            std::string_view values;
+            std::size_t count = 0;
+            bool hasCount = false;
+        };
 
-            auto typesCount = aInnerTypes.size();
-            for (auto& innerType : aInnerTypes)
+        // Returns false when aValue is not a typed container. A count that is
+        // not a number, or larger than the values can hold, throws.
+        static bool splitContainer(std::string_view aValue, ContainerParts& aParts)
+        {
+            std::array<std::string_view, 4> counted;
+            if (splitValues(aValue, CSTypeDefines::csTypeDelimiter, counted))
             {
-                innerTyeps += std::move(innerType);
-                if (--typesCount != 0)
+                aParts.type = counted[0];
+                aParts.innerTypes = counted[1];
+                if (!readCount(counted[2], counted[3], aParts))
                 {
-                    innerTyeps += CSTypeDefines::csContainerValuesDelimiter;
+                    CS::Errors::throwExceptionFailedToParse(counted[2], aParts.type);
                 }
+
+                return true;
+            }
+
+            std::array<std::string_view, 3> uncounted;
+            if (splitValues(aValue, CSTypeDefines::csTypeDelimiter, uncounted))
+            {
+                aParts = { uncounted[0], uncounted[1], uncounted[2], 0, false };
+                return true;
+            }
+
+            return false;
+        }
+
+        // Type and inner types of a typed container, false when aValue is not
+        // one. The count and the values are not looked at.
+        static bool splitContainerHeader(std::string_view aValue, std::string_view& aType, std::string_view& aInnerTypes)
+        {
+            std::array<std::string_view, 4> counted;
+            std::array<std::string_view, 3> uncounted;
+            if (splitValues(aValue, CSTypeDefines::csTypeDelimiter, counted))
+            {
+                aType = counted[0];
+                aInnerTypes = counted[1];
+                return true;
+            }
+            else if (splitValues(aValue, CSTypeDefines::csTypeDelimiter, uncounted))
+            {
+                aType = uncounted[0];
+                aInnerTypes = uncounted[1];
+                return true;
+            }
+
+            return false;
+        }
+
+        // Splits aRest, what follows an aSignature header that was already
+        // checked or is trusted, into the count and the values. Returns false
+        // on a count that is not a number or larger than the values can hold.
+        static bool trySplitCounted(std::string_view aRest, std::string_view aSignature, ContainerParts& aParts)
+        {
+            aParts.type = aSignature.substr(0, 1);
+            aParts.innerTypes = aSignature.substr(2, aSignature.size() - 3);
+
+            auto countEnd = aRest.find(CSTypeDefines::csTypeDelimiter);
+            if (countEnd == std::string_view::npos)
+            {
+                aParts.values = aRest;
+                aParts.count = 0;
+                aParts.hasCount = false;
+                return true;
+            }
+
+            return readCount(aRest.substr(0, countEnd), aRest.substr(countEnd + CSTypeDefines::csTypeDelimiter.size()), aParts);
+        }
+
+        // Stream header line, "!<16 hex digits>".
+        static void appendFingerprintHeader(std::string& aBuffer, std::uint64_t aFingerprint)
+        {
+            char digits[16];
+            for (std::size_t index = sizeof(digits); index > 0; --index, aFingerprint >>= 4)
+            {
+                digits[index - 1] = "0123456789abcdef"[aFingerprint & 0xf];
+            }
+
+            aBuffer += CSTypeDefines::csFingerprintMarker;
+            aBuffer.append(digits, sizeof(digits));
+        }
+
+        // Returns false when aLine is a record rather than a header. A header
+        // with a fingerprint that is not hex throws.
+        static bool readFingerprintHeader(std::string_view aLine, std::uint64_t& aFingerprint)
+        {
+            if (!isFingerprintHeader(aLine))
+            {
+                return false;
+            }
+            else if (!tryReadFingerprint(aLine, aFingerprint))
+            {
+                CS::Errors::throwExceptionMalformedHeader(aLine);
             }
-            
-            innerTyeps += CSTypeDefines::csTypeDelimiter;
 
-            return innerTyeps;
+            return true;
+        }
+
+        static bool isFingerprintHeader(std::string_view aLine) { return aLine.substr(0, CSTypeDefines::csFingerprintMarker.size()) == CSTypeDefines::csFingerprintMarker; }
+
+        // Fingerprint of a header line, false when it is not hex. aFingerprint
+        // is only written on success.
+        static bool tryReadFingerprint(std::string_view aLine, std::uint64_t& aFingerprint)
+        {
+            std::uint64_t fingerprint = 0;
+            auto digits = aLine.substr(CSTypeDefines::csFingerprintMarker.size());
+            auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), fingerprint, 16);
+            if (error != std::errc{} || end != digits.data() + digits.size())
+            {
+                return false;
+            }
+
+            aFingerprint = fingerprint;
+            return true;
+        }
+
+    private:
+        static bool readCount(std::string_view aCount, std::string_view aValues, ContainerParts& aParts)
+        {
+            const char* countEnd = aCount.data() + aCount.size();
+            auto [end, error] = std::from_chars(aCount.data(), countEnd, aParts.count);
+
+            // Every element but the first takes at least a delimiter.
+            if (error != std::errc{} || end != countEnd || aParts.count > aValues.size() + 1)
+            {
+                return false;
+            }
+
+            aParts.values = aValues;
+            aParts.hasCount = true;
+            return true;
         }
     };
 
-    struct DataHelper
+    struct BinaryHelper
     {
-        static std::vector<std::string> splitString(const std::string& str, const std::string& delimiter) 
+        static void appendVarint(std::string& aBuffer, std::uint64_t aValue)
         {
-            std::vector<std::string> result;
-            std::string::size_type start = 0;
-            std::string::size_type end = str.find(delimiter);
+            while (aValue >= 0x80)
+            {
+                aBuffer += static_cast<char>((aValue & 0x7F) | 0x80);
+                aValue >>= 7;
+            }
 
-            while (end != std::string::npos) {
-                result.push_back(str.substr(start, end - start));
-                start = end + delimiter.length();
-                end = str.find(delimiter, start);
+            aBuffer += static_cast<char>(aValue);
+        }
+
+        static std::size_t varintSize(std::uint64_t aValue)
+        {
+            std::size_t size = 1;
+            while (aValue >= 0x80)
+            {
+                aValue >>= 7;
+                ++size;
             }
 
-            result.push_back(str.substr(start));
+            return size;
+        }
 
-            return result;
+        static std::uint64_t readVarint(std::string_view& aData)
+        {
+            std::uint64_t value = 0;
+            if (!tryReadVarint(aData, value))
+            {
+                CS::Errors::throwExceptionMalformedBinary("varint");
+            }
+
+            return value;
         }
 
-        static std::pair<std::string, std::string> splitTwoValues(const std::string& aStr, const std::string& aDelimiter)
+        // Non-throwing readVarint, false when the input ends or overflows.
+        static bool tryReadVarint(std::string_view& aData, std::uint64_t& aValue)
         {
-            auto splited = splitString(aStr, aDelimiter);
-            if (splited.size() == 2)
+            std::uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64 && !aData.empty(); shift += 7)
             {
-                return { splited[0], splited[1] };
+                auto byte = static_cast<unsigned char>(aData.front());
+                aData.remove_prefix(1);
+
+                // The 10th byte holds bit 63 alone, anything more overflows.
+                if (shift == 63 && (byte & 0x7E) != 0)
+                {
+                    break;
+                }
+
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    aValue = value;
+                    return true;
+                }
             }
 
-            return {"", ""};
+            return false;
+        }
+
+        // Small negative numbers stay small: 0, -1, 1, -2 ... map to 0, 1, 2, 3 ...
+        static std::uint64_t zigZagEncode(std::int64_t aValue)
+        {
+            return (static_cast<std::uint64_t>(aValue) << 1) ^ static_cast<std::uint64_t>(aValue >> 63);
+        }
+
+        static std::int64_t zigZagDecode(std::uint64_t aValue)
+        {
+            return static_cast<std::int64_t>(aValue >> 1) ^ -static_cast<std::int64_t>(aValue & 1);
+        }
+
+        // Raw bytes of a trivially copyable value, little-endian for 4 and 8 byte types.
+        template<typename T>
+        static void appendRaw(std::string& aBuffer, const T& aValue)
+        {
+            char bytes[sizeof(T)];
+            if constexpr (sizeof(T) == sizeof(std::uint32_t) || sizeof(T) == sizeof(std::uint64_t))
+            {
+                using Bits = std::conditional_t<sizeof(T) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+                Bits bits;
+                std::memcpy(&bits, &aValue, sizeof(T));
+                for (std::size_t index = 0; index < sizeof(T); ++index)
+                {
+                    bytes[index] = static_cast<char>(bits >> (index * 8));
+                }
+            }
+            else
+            {
+                std::memcpy(bytes, &aValue, sizeof(T));
+            }
+
+            aBuffer.append(bytes, sizeof(T));
+        }
+
+        template<typename T>
+        static T readRaw(std::string_view& aData)
+        {
+            T value{};
+            if (!tryReadRaw(aData, value))
+            {
+                CS::Errors::throwExceptionMalformedBinary("bytes");
+            }
+
+            return value;
+        }
+
+        template<typename T>
+        static bool tryReadRaw(std::string_view& aData, T& aValue)
+        {
+            std::string_view bytes;
+            if (!tryReadBytes(aData, sizeof(T), bytes))
+            {
+                return false;
+            }
+
+            T value{};
+            if constexpr (sizeof(T) == sizeof(std::uint32_t) || sizeof(T) == sizeof(std::uint64_t))
+            {
+                using Bits = std::conditional_t<sizeof(T) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t>;
+                Bits bits = 0;
+                for (std::size_t index = 0; index < sizeof(T); ++index)
+                {
+                    bits |= static_cast<Bits>(static_cast<unsigned char>(bytes[index])) << (index * 8);
+                }
+                std::memcpy(&value, &bits, sizeof(T));
+            }
+            else
+            {
+                std::memcpy(&value, bytes.data(), sizeof(T));
+            }
+
+            aValue = value;
+            return true;
+        }
+
+        // aCount numbers as one little-endian block, a plain copy on little-endian hosts.
+        template<typename T>
+        static void appendRawBlock(std::string& aBuffer, const T* aValues, std::size_t aCount)
+        {
+            if constexpr (LittleEndianHost)
+            {
+                aBuffer.append(reinterpret_cast<const char*>(aValues), aCount * sizeof(T));
+            }
+            else
+            {
+                for (std::size_t index = 0; index < aCount; ++index)
+                {
+                    char bytes[sizeof(T)];
+                    std::memcpy(bytes, aValues + index, sizeof(T));
+                    for (std::size_t byte = 0; byte < sizeof(T); ++byte)
+                    {
+                        aBuffer += bytes[sizeof(T) - 1 - byte];
+                    }
+                }
+            }
+        }
+
+        template<typename T>
+        static void readRawBlock(std::string_view& aData, T* aValues, std::size_t aCount)
+        {
+            if (!tryReadRawBlock(aData, aValues, aCount))
+            {
+                CS::Errors::throwExceptionMalformedBinary("bytes");
+            }
+        }
+
+        template<typename T>
+        static bool tryReadRawBlock(std::string_view& aData, T* aValues, std::size_t aCount)
+        {
+            std::string_view bytes;
+            if (aCount > aData.size() / sizeof(T) || !tryReadBytes(aData, aCount * sizeof(T), bytes))
+            {
+                return false;
+            }
+
+            if constexpr (LittleEndianHost)
+            {
+                if (aCount != 0)
+                {
+                    std::memcpy(aValues, bytes.data(), bytes.size());
+                }
+            }
+            else
+            {
+                for (std::size_t index = 0; index < aCount; ++index)
+                {
+                    char value[sizeof(T)];
+                    for (std::size_t byte = 0; byte < sizeof(T); ++byte)
+                    {
+                        value[byte] = bytes[index * sizeof(T) + sizeof(T) - 1 - byte];
+                    }
+
+                    std::memcpy(aValues + index, value, sizeof(T));
+                }
+            }
+
+            return true;
         }
+
+        static std::string_view readBytes(std::string_view& aData, std::size_t aSize)
+        {
+            std::string_view bytes;
+            if (!tryReadBytes(aData, aSize, bytes))
+            {
+                CS::Errors::throwExceptionMalformedBinary("bytes");
+            }
+
+            return bytes;
+        }
+
+        static bool tryReadBytes(std::string_view& aData, std::size_t aSize, std::string_view& aBytes)
+        {
+            if (aData.size() < aSize)
+            {
+                return false;
+            }
+
+            aBytes = aData.substr(0, aSize);
+            aData.remove_prefix(aSize);
+            return true;
+        }
+
+    private:
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        static constexpr bool LittleEndianHost = false;
+#else
+        static constexpr bool LittleEndianHost = true;
+#endif
+    };
+
+    // Framed values are "<length>:<payload>" after the usual type header,
+    // e.g. "s$5:hello" or "v$s$10:5:hello1:a". Payloads are taken by length,
+    // never searched.
+    struct FramingHelper
+    {
+        // Puts the length prefix in front of the payload appended from
+        // aPayloadStart on, cheaper than measuring a container before writing it.
+        static void insertFrameLength(std::string& aBuffer, std::size_t aPayloadStart)
+        {
+            char digits[MaxDigits + 1];
+            auto [end, error] = std::to_chars(digits, digits + MaxDigits, aBuffer.size() - aPayloadStart);
+            *end++ = CSTypeDefines::csFrameLengthDelimiter.front();
+            aBuffer.insert(aPayloadStart, digits, static_cast<std::size_t>(end - digits));
+        }
+
+        static std::size_t frameLengthSize(std::size_t aLength)
+        {
+            std::size_t size = 1;
+            while (aLength >= 10)
+            {
+                aLength /= 10;
+                ++size;
+            }
+
+            return size + CSTypeDefines::csFrameLengthDelimiter.size();
+        }
+
+        // Takes the next frame off aData and returns its payload.
+        static std::string_view readFrame(std::string_view& aData)
+        {
+            std::string_view payload;
+            if (!tryReadFrame(aData, payload))
+            {
+                CS::Errors::throwExceptionMalformedFrame("frame");
+            }
+
+            return payload;
+        }
+
+        // Non-throwing readFrame, false on a bad length or a payload past the end.
+        static bool tryReadFrame(std::string_view& aData, std::string_view& aPayload)
+        {
+            const char* dataEnd = aData.data() + aData.size();
+
+            std::size_t length = 0;
+            auto [lengthEnd, error] = std::from_chars(aData.data(), dataEnd, length);
+            if (error != std::errc{} || lengthEnd == dataEnd || *lengthEnd != CSTypeDefines::csFrameLengthDelimiter.front())
+            {
+                return false;
+            }
+
+            auto headerSize = static_cast<std::size_t>(lengthEnd - aData.data()) + CSTypeDefines::csFrameLengthDelimiter.size();
+            if (length > aData.size() - headerSize)
+            {
+                return false;
+            }
+
+            aPayload = { aData.data() + headerSize, length };
+            aData.remove_prefix(headerSize + length);
+            return true;
+        }
+
+        // Takes a "type$" or "type$inner$" header off aData and returns the type
+        // and the inner types, which are empty for values that are not containers.
+        static std::pair<std::string_view, std::string_view> readTypeHeader(std::string_view& aData)
+        {
+            std::pair<std::string_view, std::string_view> header;
+            if (!tryReadTypeHeader(aData, header.first, header.second))
+            {
+                CS::Errors::throwExceptionMalformedFrame("type header");
+            }
+
+            return header;
+        }
+
+        static bool tryReadTypeHeader(std::string_view& aData, std::string_view& aType, std::string_view& aInnerTypes)
+        {
+            auto typeEnd = aData.find(CSTypeDefines::csTypeDelimiter);
+            if (typeEnd == std::string_view::npos)
+            {
+                return false;
+            }
+
+            auto type = aData.substr(0, typeEnd);
+            aData.remove_prefix(typeEnd + CSTypeDefines::csTypeDelimiter.size());
+
+            // Frame lengths start with a digit, type names never do.
+            std::string_view innerTypes;
+            if (!aData.empty() && (aData.front() < '0' || aData.front() > '9'))
+            {
+                auto innerTypesEnd = aData.find(CSTypeDefines::csTypeDelimiter);
+                if (innerTypesEnd == std::string_view::npos)
+                {
+                    return false;
+                }
+
+                innerTypes = aData.substr(0, innerTypesEnd);
+                aData.remove_prefix(innerTypesEnd + CSTypeDefines::csTypeDelimiter.size());
+            }
+
+            aType = type;
+            aInnerTypes = innerTypes;
+            return true;
+        }
+
+        // Steps over a whole typed value without looking at its payload.
+        static void skipTypedValue(std::string_view& aData)
+        {
+            readTypeHeader(aData);
+            readFrame(aData);
+        }
+
+        // Takes the "|" between two fields off aData.
+        static void readValueDelimiter(std::string_view& aData)
+        {
+            if (!tryReadValueDelimiter(aData))
+            {
+                CS::Errors::throwExceptionMalformedFrame("value delimiter");
+            }
+        }
+
+        static bool tryReadValueDelimiter(std::string_view& aData)
+        {
+            if (aData.substr(0, CSTypeDefines::csValueDelimiter.size()) != CSTypeDefines::csValueDelimiter)
+            {
+                return false;
+            }
+
+            aData.remove_prefix(CSTypeDefines::csValueDelimiter.size());
+            return true;
+        }
+
+    private:
+        static constexpr std::size_t MaxDigits = std::numeric_limits<std::size_t>::digits10 + 1;
+    };
+
+    // Largest element counts the decoders accept, shared by every thread.
+    // Counts are read before the elements, so a hostile count is rejected
+    // before anything is reserved for it.
+    struct Limits
+    {
+        static inline std::size_t maxVectorElements = std::size_t(1) << 24;
+        static inline std::size_t maxMapEntries = std::size_t(1) << 24;
+
+        static void checkCount(std::uint64_t aCount, std::size_t aLimit, std::string_view aType)
+        {
+            if (aCount > aLimit)
+            {
+                CS::Errors::throwExceptionCountOverLimit(aType, aCount, aLimit);
+            }
+        }
+    };
+
+    // Per thread event counts the field statistics (CSFieldStats.h) take
+    // their share of around every field they measure.
+    struct Events
+    {
+        static inline thread_local std::uint64_t allocations = 0;
+        static inline thread_local std::uint64_t typeMismatches = 0;
+
+        // Call from a replaced operator new to get allocations counted per field.
+        static void countAllocation() noexcept { ++allocations; }
     };
 
     struct Errors
     {
-        static void throwExceptionWithTypeMismatch(const std::string& aTypeUsed, const std::string& aTypeRequired)
+        // Throws the error a non-throwing decode reported with aStatus for
+        // aValue read as aType, the throwing casts wrap the try ones with it.
+        // Does nothing for Ok.
+        static void throwExceptionWithStatus(CSTypeDefines::DecodeStatus aStatus, std::string_view aValue, std::string_view aType)
+        {
+            if (aStatus != CSTypeDefines::DecodeStatus::Ok)
+            {
+                throwStatus(aStatus, aValue, aType);
+            }
+        }
+
+        static void throwExceptionWithTypeMismatch(std::string_view aTypeUsed, std::string_view aTypeRequired)
         {
+#if defined(CS_FIELD_STATS)
+            ++CS::Events::typeMismatches;
+#endif
+
             std::string usedFullType = CS::TypeHelper::tryGetFullType(aTypeUsed);
-            std::string requiredFullType = CS::TypeHelper::tryGetFullType(aTypeUsed);
+            std::string requiredFullType = CS::TypeHelper::tryGetFullType(aTypeRequired);
             std::string errorMessage = "Type mismatch. Trying to convert from " + usedFullType + " to " + requiredFullType;
 
             throw std::runtime_error(errorMessage);
         }
 
+        static void throwExceptionFailedToParse(std::string_view aValue, std::string_view aType)
+        {
+
+            std::string errorMessage = "Parse error. Failed to read \"" + std::string(aValue) + "\" as " + CS::TypeHelper::tryGetFullType(aType);
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionMalformedBinary(std::string_view aWhat)
+        {
+
+            std::string errorMessage = "Malformed binary. Input ended or overflowed while reading " + std::string(aWhat);
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionMalformedFrame(std::string_view aWhat)
+        {
+
+            std::string errorMessage = "Malformed frame. Input ended or did not match while reading " + std::string(aWhat);
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionMalformedColumn(std::string_view aWhat)
+        {
+
+            std::string errorMessage = "Malformed column. Input ended or did not match while reading " + std::string(aWhat);
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionCountOverLimit(std::string_view aType, std::uint64_t aCount, std::size_t aLimit)
+        {
+
+            std::string errorMessage = "Count over limit. " + CS::TypeHelper::tryGetFullType(aType) + " of " + std::to_string(aCount) 
+                + " elements, at most " + std::to_string(aLimit) + " are accepted";
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        // Same when the count itself was not kept, only that it passed aLimit.
+        static void throwExceptionCountOverLimit(std::string_view aType, std::size_t aLimit)
+        {
+            std::string errorMessage = "Count over limit. " + CS::TypeHelper::tryGetFullType(aType) + " of more than " + std::to_string(aLimit) + " elements";
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionMalformedHeader(std::string_view aLine)
+        {
+
+            std::string errorMessage = "Malformed header. Failed to read fingerprint from \"" + std::string(aLine) + "\"";
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionTokenOverLimit(std::size_t aSize, std::size_t aLimit)
+        {
+
+            std::string errorMessage = "Token over limit. " + std::to_string(aSize) + " bytes without a delimiter, at most " 
+                + std::to_string(aLimit) + " are kept";
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionMalformedDelta(std::string_view aWhat)
+        {
+
+            std::string errorMessage = "Malformed delta. Failed to read " + std::string(aWhat);
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionDeltaBaseMismatch()
+        {
+            std::string errorMessage = "Delta base mismatch. Previous object is of a different struct type";
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionSelectionMismatch()
+        {
+            std::string errorMessage = "Selection mismatch. Fields were selected for a different struct type";
+
+            throw std::runtime_error(errorMessage);
+        }
+
+        static void throwExceptionFieldNotFound(std::string_view aKey)
+        {
+            std::string errorMessage = "Field not found. Line save has no field " + std::string(aKey);
+
+            throw std::runtime_error(errorMessage);
+        }
+
         static void throwExceptionTypeRedefinition(const std::string& aKeyWrited)
         {
             std::string errorMessage = "Type Redefinition. Trying to write " + aKeyWrited + " when already defined.";
@@ -206,6 +1142,30 @@ struct CS
 
             throw std::runtime_error(errorMessage);
         }
+
+    private:
+        // Out of line, so the Ok check above stays cheap to inline.
+        static void throwStatus(CSTypeDefines::DecodeStatus aStatus, std::string_view aValue, std::string_view aType)
+        {
+            switch (aStatus)
+            {
+            case CSTypeDefines::DecodeStatus::TypeMismatch:
+                throwExceptionWithTypeMismatch(aValue.substr(0, aValue.find(CSTypeDefines::csTypeDelimiter)), aType);
+                break;
+            case CSTypeDefines::DecodeStatus::MalformedBinary:
+                throwExceptionMalformedBinary(CS::TypeHelper::tryGetFullType(aType));
+                break;
+            case CSTypeDefines::DecodeStatus::MalformedFrame:
+                throwExceptionMalformedFrame(CS::TypeHelper::tryGetFullType(aType));
+                break;
+            case CSTypeDefines::DecodeStatus::CountOverLimit:
+                throwExceptionCountOverLimit(aType, aType == CSTypeDefines::csMapType ? CS::Limits::maxMapEntries : CS::Limits::maxVectorElements);
+                break;
+            default:
+                throwExceptionFailedToParse(aValue, aType);
+                break;
+            }
+        }
     };
 
 };
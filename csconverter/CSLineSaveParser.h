@@ -0,0 +1,510 @@
+#ifndef __CS_LINE_SAVE_PARSER_H__
+#define __CS_LINE_SAVE_PARSER_H__
+
+#include "CSConvertableStruct.h"
+
+#include <exception>
+
+// Push parser for text line saves that arrive in pieces, e.g. from a socket
+// or a pipe. feed() takes chunks of any size and cut anywhere; every field is
+// decoded into the record as soon as its delimiter arrives, and vector and
+// map fields element by element. Only the unfinished token at the end of a
+// chunk is copied and kept, so memory per connection is bounded by the
+// longest scalar or element instead of the longest record.
+//
+//	LineSaveParser parser(record);
+//	while (auto size = receive(buffer))
+//	{
+//		parser.feed({ buffer, size }, [](ConvertableStruct& aRecord) { ... });
+//	}
+//	parser.finish([](ConvertableStruct& aRecord) { ... });
+//
+// The callback sees the record after each record delimiter. Records decode
+// over the previous one like ConvertableStruct::convertLineSaveToObject, and
+// fingerprint headers (LineSaveWriter::writeFingerprint) are honoured.
+struct LineSaveParser
+{
+public:
+	static constexpr std::size_t DefaultMaxTokenSize = 16 * 1024 * 1024;
+
+	explicit LineSaveParser(ConvertableStruct& aRecord, std::size_t aMaxTokenSize = DefaultMaxTokenSize)
+		: record{ aRecord }, maxTokenSize{ aMaxTokenSize } {}
+
+	LineSaveParser(const LineSaveParser&) = delete;
+	LineSaveParser& operator=(const LineSaveParser&) = delete;
+
+	// Decodes aChunk and calls aCallback(ConvertableStruct&) for every record
+	// it completes, returning their amount. A record that fails is skipped up
+	// to its end; its error is rethrown once the rest of the chunk is done.
+	template<typename Callback>
+	std::size_t feed(std::string_view aChunk, Callback&& aCallback)
+	{
+		std::size_t recordsAmount = 0;
+		std::exception_ptr error;
+
+		while (!aChunk.empty())
+		{
+			bool completed = false;
+			try
+			{
+				completed = step(aChunk);
+			}
+			catch (...)
+			{
+				if (!error)
+				{
+					error = std::current_exception();
+				}
+
+				skipRecord();
+			}
+
+			if (completed)
+			{
+				++recordsAmount;
+				aCallback(record);
+			}
+		}
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+
+		return recordsAmount;
+	}
+
+	// Ends the input. A last record without a trailing delimiter completes here.
+	template<typename Callback>
+	std::size_t finish(Callback&& aCallback)
+	{
+		if (state == State::RecordStart)
+		{
+			return 0;
+		}
+
+		return feed(CSTypeDefines::csRecordDelimiter, std::forward<Callback>(aCallback));
+	}
+
+	// Drops a partly received record, e.g. after the connection was reset.
+	void reset()
+	{
+		pending.clear();
+		takenPending = false;
+		startRecord();
+	}
+
+	// Bytes kept from previous chunks.
+	std::size_t buffered() const { return pending.size(); }
+
+private:
+	enum class State
+	{
+		RecordStart,
+		Header,
+		Value,
+		Signature,
+		Count,
+		Elements,
+		SkipFields,
+		SkipRecord
+	};
+
+	ConvertableStruct& record;
+	std::size_t maxTokenSize;
+
+	State state = State::RecordStart;
+	std::string pending;
+	// The last token was handed out of pending, which is cleared before the next one.
+	bool takenPending = false;
+	// Delimiter of the token being decoded, tells an error after a record end
+	// from one inside the record.
+	char delimiter = 0;
+
+	std::size_t fieldIndex = 0;
+	IConvertableValue* field = nullptr;
+	bool isMap = false;
+	// Storage each container field recycles, kept from record to record.
+	std::vector<std::shared_ptr<void>> spares;
+
+	std::size_t elementsAmount = 0;
+	std::size_t count = 0;
+	bool hasCount = false;
+
+	std::uint64_t fingerprint = 0;
+	bool unchecked = false;
+
+	// Consumes the next token, or the rest of the chunk when it holds no
+	// delimiter. Returns true when a record was completed.
+	bool step(std::string_view& aChunk)
+	{
+		delimiter = 0;
+
+		switch (state)
+		{
+		case State::RecordStart:
+			if (aChunk.front() == recordEnd())
+			{
+				aChunk.remove_prefix(1);
+				return false;
+			}
+
+			if (aChunk.front() == CSTypeDefines::csFingerprintMarker.front())
+			{
+				state = State::Header;
+				return false;
+			}
+
+			startField();
+			return false;
+
+		case State::Header:
+			return readHeader(aChunk);
+
+		case State::Value:
+			return readValue(aChunk);
+
+		case State::Signature:
+			return readSignature(aChunk);
+
+		case State::Count:
+			return readCount(aChunk);
+
+		case State::Elements:
+			return readElement(aChunk);
+
+		case State::SkipFields:
+		case State::SkipRecord:
+			return skipToRecordEnd(aChunk);
+		}
+
+		return false;
+	}
+
+	// Takes the bytes up to the first of aDelimiters out of aChunk into
+	// aToken. When the chunk ends first they are kept for the next one.
+	bool readToken(std::string_view& aChunk, std::string_view aDelimiters, std::string_view& aToken)
+	{
+		releasePending();
+
+		auto tokenEnd = aChunk.find_first_of(aDelimiters);
+		if (tokenEnd == std::string_view::npos)
+		{
+			keep(aChunk);
+			aChunk = {};
+			return false;
+		}
+
+		delimiter = aChunk[tokenEnd];
+		if (pending.empty())
+		{
+			aToken = aChunk.substr(0, tokenEnd);
+		}
+		else
+		{
+			keep(aChunk.substr(0, tokenEnd));
+			aToken = pending;
+			takenPending = true;
+		}
+
+		aChunk.remove_prefix(tokenEnd + 1);
+		aToken = trimToken(aToken);
+		return true;
+	}
+
+	void keep(std::string_view aBytes)
+	{
+		if (pending.size() + aBytes.size() > maxTokenSize)
+		{
+			CS::Errors::throwExceptionTokenOverLimit(pending.size() + aBytes.size(), maxTokenSize);
+		}
+
+		pending.append(aBytes.data(), aBytes.size());
+	}
+
+	void releasePending()
+	{
+		if (takenPending)
+		{
+			pending.clear();
+			takenPending = false;
+		}
+	}
+
+	// The last token of a "\r\n" line.
+	std::string_view trimToken(std::string_view aToken) const
+	{
+		if (delimiter == recordEnd() && !aToken.empty() && aToken.back() == '\r')
+		{
+			aToken.remove_suffix(1);
+		}
+
+		return aToken;
+	}
+
+	void startRecord()
+	{
+		state = State::RecordStart;
+		fieldIndex = 0;
+	}
+
+	void startField()
+	{
+		auto& fields = record.getSchema() ? record.getSchema()->getFields() : noFields();
+		if (fieldIndex >= fields.size())
+		{
+			// Values past the known fields are ignored, as by convertLineSaveToObject.
+			state = State::SkipFields;
+			return;
+		}
+
+		field = fields[fieldIndex].value.get();
+		if (field->hasElements())
+		{
+			isMap = field->signature().front() == CSTypeDefines::csMapTag;
+			state = State::Signature;
+		}
+		else
+		{
+			state = State::Value;
+		}
+	}
+
+	// Moves to the next field after a '|', or completes the record after a newline.
+	bool endField()
+	{
+		if (delimiter == recordEnd())
+		{
+			startRecord();
+			return true;
+		}
+
+		++fieldIndex;
+		startField();
+		return false;
+	}
+
+	bool readHeader(std::string_view& aChunk)
+	{
+		std::string_view line;
+		if (!readToken(aChunk, CSTypeDefines::csRecordDelimiter, line))
+		{
+			return false;
+		}
+
+		CS::DataHelper::readFingerprintHeader(line, fingerprint);
+		unchecked = record.getSchema() && fingerprint == record.getSchema()->fingerprint();
+		startRecord();
+		return false;
+	}
+
+	bool readValue(std::string_view& aChunk)
+	{
+		std::string_view value;
+		if (!readToken(aChunk, valueEnds(), value))
+		{
+			return false;
+		}
+
+		return setValue(value);
+	}
+
+	bool setValue(std::string_view aValue)
+	{
+		// A line holding only "\r".
+		if (delimiter == recordEnd() && fieldIndex == 0 && aValue.empty())
+		{
+			startRecord();
+			return false;
+		}
+
+		if (unchecked)
+		{
+			field->setUncheckedValue(&record, aValue);
+		}
+		else
+		{
+			field->setValue(&record, aValue);
+		}
+
+		return endField();
+	}
+
+	// Collects the first signature().size() bytes of a container field. Its
+	// own header continues element by element, anything else is read whole
+	// and decoded (or rejected) by setValue.
+	bool readSignature(std::string_view& aChunk)
+	{
+		releasePending();
+
+		auto signature = field->signature();
+		auto header = aChunk.substr(0, signature.size() - pending.size());
+
+		auto valueEnd = header.find_first_of(valueEnds());
+		if (valueEnd != std::string_view::npos)
+		{
+			delimiter = header[valueEnd];
+			keep(header.substr(0, valueEnd));
+			aChunk.remove_prefix(valueEnd + 1);
+			takenPending = true;
+
+			return setValue(trimToken(pending));
+		}
+
+		keep(header);
+		aChunk.remove_prefix(header.size());
+		if (pending.size() < signature.size())
+		{
+			return false;
+		}
+
+		if (pending == signature)
+		{
+			pending.clear();
+			state = State::Count;
+		}
+		else
+		{
+			state = State::Value;
+		}
+
+		return false;
+	}
+
+	// The count of "v$s$3$a^b^c", or the first element of a line without counts.
+	bool readCount(std::string_view& aChunk)
+	{
+		std::string_view token;
+		if (!readToken(aChunk, countEnds(), token))
+		{
+			return false;
+		}
+
+		elementsAmount = 0;
+		hasCount = delimiter == CSTypeDefines::csTypeDelimiterTag;
+		count = 0;
+
+		if (hasCount)
+		{
+			auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), count);
+			if (error != std::errc{} || end != token.data() + token.size())
+			{
+				CS::Errors::throwExceptionFailedToParse(token, field->signature().substr(0, 1));
+			}
+
+			field->beginElements(&record, count, true, spare());
+			state = State::Elements;
+			return false;
+		}
+
+		field->beginElements(&record, 0, false, spare());
+		state = State::Elements;
+		return setElement(token);
+	}
+
+	bool readElement(std::string_view& aChunk)
+	{
+		std::string_view element;
+		if (!readToken(aChunk, elementEnds(), element))
+		{
+			return false;
+		}
+
+		return setElement(element);
+	}
+
+	bool setElement(std::string_view aElement)
+	{
+		bool valueEnded = delimiter == CSTypeDefines::csValueDelimiter.front() || delimiter == recordEnd();
+
+		// Nothing after the header is no elements, apart from a vector counted
+		// to hold one, empty, element.
+		bool noElements = valueEnded && elementsAmount == 0 && aElement.empty() && (isMap || !hasCount || count == 0);
+		if (!noElements)
+		{
+			field->setElement(&record, elementsAmount++, aElement, spare());
+		}
+
+		if (!valueEnded)
+		{
+			return false;
+		}
+
+		field->endElements(&record, elementsAmount, count, hasCount, spare());
+		return endField();
+	}
+
+	std::shared_ptr<void>& spare()
+	{
+		if (fieldIndex >= spares.size())
+		{
+			spares.resize(fieldIndex + 1);
+		}
+
+		return spares[fieldIndex];
+	}
+
+	bool skipToRecordEnd(std::string_view& aChunk)
+	{
+		auto lineEnd = aChunk.find(recordEnd());
+		if (lineEnd == std::string_view::npos)
+		{
+			aChunk = {};
+			return false;
+		}
+
+		aChunk.remove_prefix(lineEnd + 1);
+
+		bool completed = state == State::SkipFields;
+		startRecord();
+		return completed;
+	}
+
+	// After an error the rest of the record is skipped, unless the failed
+	// token was its last one.
+	void skipRecord()
+	{
+		pending.clear();
+		takenPending = false;
+
+		if (delimiter == recordEnd())
+		{
+			startRecord();
+		}
+		else
+		{
+			state = State::SkipRecord;
+		}
+	}
+
+	static char recordEnd() { return CSTypeDefines::csRecordDelimiter.front(); }
+
+	// Delimiters ending a token, per state.
+	static const std::string& valueEnds()
+	{
+		static const std::string delimiters = CSTypeDefines::csValueDelimiter + CSTypeDefines::csRecordDelimiter;
+		return delimiters;
+	}
+
+	const std::string& elementEnds() const
+	{
+		static const std::string vectorDelimiters = CSTypeDefines::csContainerValuesDelimiter + valueEnds();
+		static const std::string mapDelimiters = CSTypeDefines::csMapValueDelimiter + valueEnds();
+		return isMap ? mapDelimiters : vectorDelimiters;
+	}
+
+	const std::string& countEnds() const
+	{
+		static const std::string vectorDelimiters = CSTypeDefines::csTypeDelimiter + CSTypeDefines::csContainerValuesDelimiter + valueEnds();
+		static const std::string mapDelimiters = CSTypeDefines::csTypeDelimiter + CSTypeDefines::csMapValueDelimiter + valueEnds();
+		return isMap ? mapDelimiters : vectorDelimiters;
+	}
+
+	static const std::vector<ConvertableSchema::Field>& noFields()
+	{
+		static const std::vector<ConvertableSchema::Field> fields;
+		return fields;
+	}
+};
+
+#endif // !__CS_LINE_SAVE_PARSER_H__
@@ -0,0 +1,307 @@
+#ifndef __CS_LINE_SAVE_STREAM_H__
+#define __CS_LINE_SAVE_STREAM_H__
+
+#include "CSConvertableStruct.h"
+
+#include <istream>
+#include <ostream>
+
+// Reads newline delimited text line saves in fixed-size chunks, so memory
+// stays bounded by the chunk size (or the longest record, if larger) no matter
+// how big the input is. Lines returned by readLine stay valid until the next
+// call. Memory-mapped or already loaded files can be read without any copy
+// through the std::string_view constructor.
+// Fingerprint header lines written by LineSaveWriter::writeFingerprint are
+// taken out of the records by read and forEach; records after a header that
+// matches the decoded struct skip their field type checks.
+struct LineSaveReader
+{
+public:
+	static constexpr std::size_t DefaultChunkSize = 64 * 1024;
+
+	explicit LineSaveReader(std::istream& aStream, std::size_t aChunkSize = DefaultChunkSize)
+		: stream{ &aStream }
+	{
+		buffer.resize(aChunkSize > 0 ? aChunkSize : DefaultChunkSize);
+	}
+
+	explicit LineSaveReader(std::string_view aData)
+		: memory{ aData } {}
+
+	bool readLine(std::string_view& aLine)
+	{
+		if (!stream)
+		{
+			return readMemoryLine(aLine);
+		}
+
+		while (true)
+		{
+			auto lineEnd = std::string_view(buffer.data() + begin, end - begin).find(CSTypeDefines::csRecordDelimiter);
+			if (lineEnd != std::string_view::npos)
+			{
+				lineOffset = offset + begin;
+				aLine = trimLine(std::string_view(buffer.data() + begin, lineEnd));
+				begin += lineEnd + CSTypeDefines::csRecordDelimiter.size();
+				return true;
+			}
+
+			if (finished)
+			{
+				if (begin == end)
+				{
+					return false;
+				}
+
+				// Last record without a trailing delimiter.
+				lineOffset = offset + begin;
+				aLine = trimLine(std::string_view(buffer.data() + begin, end - begin));
+				begin = end;
+				return true;
+			}
+
+			fill();
+		}
+	}
+
+	// Decodes the next non-empty record into aObject. Returns false at the end of input.
+	bool read(ConvertableStruct& aObject)
+	{
+		std::string_view line;
+		if (!readRecord(line))
+		{
+			return false;
+		}
+
+		if (hasFingerprint)
+		{
+			aObject.convertLineSaveToObject(line, streamFingerprint);
+		}
+		else
+		{
+			aObject.convertLineSaveToObject(line);
+		}
+
+		return true;
+	}
+
+	// Same with malformed records reported in aResult instead of thrown, so
+	// reading goes on with the next record. Offsets are within the record.
+	// A header that is not hex is reported as MalformedHeader with its byte
+	// offset in the input, and the records after it get the full checks.
+	bool tryRead(ConvertableStruct& aObject, DecodeResult& aResult)
+	{
+		std::string_view line;
+		bool malformedHeader = false;
+		if (!readRecord(line, &malformedHeader))
+		{
+			return false;
+		}
+
+		if (malformedHeader)
+		{
+			aResult = DecodeError{ CSTypeDefines::DecodeStatus::MalformedHeader, lineOffset, {} };
+		}
+		else
+		{
+			aResult = hasFingerprint ? aObject.tryConvertLineSaveToObject(line, streamFingerprint) : aObject.tryConvertLineSaveToObject(line);
+		}
+
+		return true;
+	}
+
+	// Calls aCallback(std::string_view) for every non-empty record and returns their amount.
+	template<typename Callback>
+	std::size_t forEach(Callback&& aCallback)
+	{
+		std::size_t recordsAmount = 0;
+
+		std::string_view line;
+		while (readRecord(line))
+		{
+			aCallback(line);
+			++recordsAmount;
+		}
+
+		return recordsAmount;
+	}
+
+	// Fingerprint of the last header read, for the records after it.
+	bool fingerprinted() const { return hasFingerprint; }
+	std::uint64_t fingerprint() const { return streamFingerprint; }
+
+private:
+	std::istream* stream = nullptr;
+	std::string buffer;
+	std::size_t begin = 0;
+	std::size_t end = 0;
+	bool finished = false;
+
+	std::string_view memory;
+
+	// Bytes of input before the buffer or memory, and before the last line.
+	std::size_t offset = 0;
+	std::size_t lineOffset = 0;
+
+	std::uint64_t streamFingerprint = 0;
+	bool hasFingerprint = false;
+
+	// Next non-empty line that is not a header. A header that is not hex
+	// throws, or with aMalformedHeader is returned as the line with it set.
+	bool readRecord(std::string_view& aLine, bool* aMalformedHeader = nullptr)
+	{
+		while (readLine(aLine))
+		{
+			if (CS::DataHelper::isFingerprintHeader(aLine))
+			{
+				hasFingerprint = CS::DataHelper::tryReadFingerprint(aLine, streamFingerprint);
+				if (!hasFingerprint)
+				{
+					if (!aMalformedHeader)
+					{
+						CS::Errors::throwExceptionMalformedHeader(aLine);
+					}
+
+					*aMalformedHeader = true;
+					return true;
+				}
+			}
+			else if (!aLine.empty())
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static std::string_view trimLine(std::string_view aLine)
+	{
+		if (!aLine.empty() && aLine.back() == '\r')
+		{
+			aLine.remove_suffix(1);
+		}
+
+		return aLine;
+	}
+
+	bool readMemoryLine(std::string_view& aLine)
+	{
+		if (memory.empty())
+		{
+			return false;
+		}
+
+		lineOffset = offset;
+
+		auto lineEnd = memory.find(CSTypeDefines::csRecordDelimiter);
+		if (lineEnd == std::string_view::npos)
+		{
+			aLine = trimLine(memory);
+			offset += memory.size();
+			memory = {};
+		}
+		else
+		{
+			aLine = trimLine(memory.substr(0, lineEnd));
+			offset += lineEnd + CSTypeDefines::csRecordDelimiter.size();
+			memory.remove_prefix(lineEnd + CSTypeDefines::csRecordDelimiter.size());
+		}
+
+		return true;
+	}
+
+	// Moves the unfinished record to the front and reads the next chunk after
+	// it. The buffer only grows when a single record does not fit into it.
+	void fill()
+	{
+		if (begin > 0)
+		{
+			std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+			offset += begin;
+			end -= begin;
+			begin = 0;
+		}
+
+		if (end == buffer.size())
+		{
+			buffer.resize(buffer.size() * 2);
+		}
+
+		stream->read(buffer.data() + end, static_cast<std::streamsize>(buffer.size() - end));
+		end += static_cast<std::size_t>(stream->gcount());
+
+		if (!*stream)
+		{
+			finished = true;
+		}
+	}
+};
+
+// Collects encoded records in one buffer and hands them to the stream in
+// large writes. Flushed when the buffer passes its size and on destruction.
+struct LineSaveWriter
+{
+public:
+	static constexpr std::size_t DefaultBufferSize = 64 * 1024;
+
+	explicit LineSaveWriter(std::ostream& aStream, std::size_t aBufferSize = DefaultBufferSize)
+		: stream{ aStream }, flushSize{ aBufferSize }
+	{
+		buffer.reserve(aBufferSize + aBufferSize / 2);
+	}
+
+	~LineSaveWriter()
+	{
+		flush();
+	}
+
+	LineSaveWriter(const LineSaveWriter&) = delete;
+	LineSaveWriter& operator=(const LineSaveWriter&) = delete;
+
+	void write(ConvertableStruct& aObject)
+	{
+		aObject.convertObjectToLineSave(buffer);
+		finishRecord();
+	}
+
+	void writeLine(std::string_view aLine)
+	{
+		buffer += aLine;
+		finishRecord();
+	}
+
+	// Header line telling readers which schema the records after it were
+	// written with, e.g. record.fingerprint(). Written once per stream, or
+	// again whenever the record type changes.
+	void writeFingerprint(std::uint64_t aFingerprint)
+	{
+		CS::DataHelper::appendFingerprintHeader(buffer, aFingerprint);
+		finishRecord();
+	}
+
+	void flush()
+	{
+		if (!buffer.empty())
+		{
+			stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			buffer.clear();
+		}
+	}
+
+private:
+	std::ostream& stream;
+	std::size_t flushSize;
+	std::string buffer;
+
+	void finishRecord()
+	{
+		buffer += CSTypeDefines::csRecordDelimiter;
+		if (buffer.size() >= flushSize)
+		{
+			flush();
+		}
+	}
+};
+
+#endif // !__CS_LINE_SAVE_STREAM_H__
@@ -0,0 +1,306 @@
+#ifndef __CS_LINE_SAVE_VIEW_H__
+#define __CS_LINE_SAVE_VIEW_H__
+
+#include "CSConvertableSchema.h"
+#include "CSStructuralIndex.h"
+
+// Converts container tokens for the lazy ranges below. std::string_view
+// element types get the raw token and accept any inner type.
+struct LineSaveToken
+{
+	template<typename Type>
+	static Type convert(std::string_view aToken)
+	{
+		if constexpr (std::is_same_v<Type, std::string_view>)
+		{
+			return aToken;
+		}
+		else
+		{
+			ValueConverter<Type> converter;
+			return converter.cast(aToken);
+		}
+	}
+
+	template<typename Type>
+	static void checkType(std::string_view aType)
+	{
+		if constexpr (!std::is_same_v<Type, std::string_view>)
+		{
+			ValueConverter<Type> converter;
+			if (!converter.typeOf(aType))
+			{
+				CS::Errors::throwExceptionWithTypeMismatch(aType, converter.type());
+			}
+		}
+	}
+};
+
+// Elements of a "v$" value, converted one at a time while iterating.
+template<typename ValueType>
+struct LineSaveElements
+{
+public:
+	class iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = ValueType;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = ValueType;
+
+		iterator() = default;
+		explicit iterator(StructuralIndex::SplitView::iterator aToken) : token{ aToken } {}
+
+		ValueType operator*() const { return LineSaveToken::convert<ValueType>(*token); }
+
+		iterator& operator++()
+		{
+			++token;
+			return *this;
+		}
+
+		iterator operator++(int)
+		{
+			iterator previous = *this;
+			++token;
+			return previous;
+		}
+
+		bool operator==(const iterator& aOther) const { return token == aOther.token; }
+		bool operator!=(const iterator& aOther) const { return token != aOther.token; }
+
+	private:
+		StructuralIndex::SplitView::iterator token;
+	};
+
+	LineSaveElements() = default;
+	LineSaveElements(StructuralIndex::SplitView aValues, bool aEmpty) : values{ aValues }, isEmpty{ aEmpty } {}
+
+	iterator begin() const { return isEmpty ? end() : iterator(values.begin()); }
+	iterator end() const { return iterator(); }
+
+	bool empty() const { return isEmpty; }
+
+private:
+	StructuralIndex::SplitView values;
+	bool isEmpty = true;
+};
+
+// Entries of an "m$" value, converted to std::pair one at a time while iterating.
+template<typename KeyType, typename ValueType>
+struct LineSaveEntries
+{
+public:
+	class iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::pair<KeyType, ValueType>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = value_type;
+
+		iterator() = default;
+		explicit iterator(StructuralIndex::PairSplitView::iterator aToken) : token{ aToken } {}
+
+		value_type operator*() const
+		{
+			return { LineSaveToken::convert<KeyType>(token->first), LineSaveToken::convert<ValueType>(token->second) };
+		}
+
+		iterator& operator++()
+		{
+			++token;
+			return *this;
+		}
+
+		iterator operator++(int)
+		{
+			iterator previous = *this;
+			++token;
+			return previous;
+		}
+
+		bool operator==(const iterator& aOther) const { return token == aOther.token; }
+		bool operator!=(const iterator& aOther) const { return token != aOther.token; }
+
+	private:
+		StructuralIndex::PairSplitView::iterator token;
+	};
+
+	LineSaveEntries() = default;
+	LineSaveEntries(StructuralIndex::PairSplitView aValues, bool aEmpty) : values{ aValues }, isEmpty{ aEmpty } {}
+
+	iterator begin() const { return isEmpty ? end() : iterator(values.begin()); }
+	iterator end() const { return iterator(); }
+
+	bool empty() const { return isEmpty; }
+
+private:
+	StructuralIndex::PairSplitView values;
+	bool isEmpty = true;
+};
+
+// Read-only access to a text line save without decoding it into a struct.
+// The field boundaries are found once; get<T> then parses only the field it
+// is asked for. elements/entries index the delimiters of that one container
+// with StructuralIndex on first use and walk it without building a
+// std::vector or std::map.
+// Keys are resolved through the schema of the struct that wrote the line,
+// e.g. record.getSchema(). The viewed data must outlive the view.
+//
+//	LineSaveView view(line, record.getSchema());
+//	int value = view.get<int>("value");
+//	for (auto [key, amount] : view.entries<std::string_view, int>("testMap")) { ... }
+struct LineSaveView
+{
+public:
+	LineSaveView() = default;
+
+	explicit LineSaveView(std::string_view aLineSave, const ConvertableSchema* aSchema = nullptr)
+		: schema{ aSchema }
+	{
+		assign(aLineSave);
+	}
+
+	// Points the view at another line save, reusing the field table and the
+	// container indexes of the previous line.
+	void assign(std::string_view aLineSave)
+	{
+		lineSave = aLineSave;
+		fields.clear();
+
+		if (!aLineSave.empty())
+		{
+			for (auto field : CS::DataHelper::split(aLineSave, CSTypeDefines::csValueDelimiter))
+			{
+				fields.push_back(field);
+			}
+		}
+
+		if (containerIndexes.size() < fields.size())
+		{
+			containerIndexes.resize(fields.size());
+		}
+
+		indexedContainers.assign(fields.size(), false);
+	}
+
+	std::string_view data() const { return lineSave; }
+	std::size_t size() const { return fields.size(); }
+
+	bool contains(std::string_view aKey) const
+	{
+		auto index = schema ? schema->indexOf(aKey) : ConvertableSchema::NotFound;
+		return index != ConvertableSchema::NotFound && index < fields.size();
+	}
+
+	// Typed text of the field, e.g. "i$10".
+	std::string_view raw(std::size_t aIndex) const
+	{
+		if (aIndex >= fields.size())
+		{
+			CS::Errors::throwExceptionFieldNotFound(std::to_string(aIndex));
+		}
+
+		return fields[aIndex];
+	}
+
+	std::string_view raw(std::string_view aKey) const { return fields[indexOf(aKey)]; }
+
+	template<typename Type>
+	Type get(std::size_t aIndex) const
+	{
+		ValueConverter<Type> converter;
+		return converter.castTyped(raw(aIndex));
+	}
+
+	template<typename Type>
+	Type get(std::string_view aKey) const { return get<Type>(indexOf(aKey)); }
+
+	template<typename ValueType>
+	LineSaveElements<ValueType> elements(std::size_t aIndex) const
+	{
+		auto parts = splitContainer(raw(aIndex), CSTypeDefines::csVectorType);
+		LineSaveToken::checkType<ValueType>(parts.innerTypes);
+
+		auto& index = containerIndex(aIndex, parts.values);
+		return LineSaveElements<ValueType>(index.split(CSTypeDefines::csContainerValuesDelimiter), isEmpty(parts));
+	}
+
+	template<typename ValueType>
+	LineSaveElements<ValueType> elements(std::string_view aKey) const { return elements<ValueType>(indexOf(aKey)); }
+
+	template<typename KeyType, typename ValueType>
+	LineSaveEntries<KeyType, ValueType> entries(std::size_t aIndex) const
+	{
+		auto parts = splitContainer(raw(aIndex), CSTypeDefines::csMapType);
+
+		auto [keyType, valueType] = CS::DataHelper::splitTwoValues(parts.innerTypes, CSTypeDefines::csContainerValuesDelimiter);
+		LineSaveToken::checkType<KeyType>(keyType);
+		LineSaveToken::checkType<ValueType>(valueType);
+
+		auto& index = containerIndex(aIndex, parts.values);
+		return LineSaveEntries<KeyType, ValueType>(
+			index.splitPairs(0, parts.values.size(), CSTypeDefines::csMapValueDelimiter, CSTypeDefines::csContainerValuesDelimiter), isEmpty(parts));
+	}
+
+	template<typename KeyType, typename ValueType>
+	LineSaveEntries<KeyType, ValueType> entries(std::string_view aKey) const { return entries<KeyType, ValueType>(indexOf(aKey)); }
+
+private:
+	std::string_view lineSave;
+	const ConvertableSchema* schema = nullptr;
+	// Typed text of every field, in line save order.
+	std::vector<std::string_view> fields;
+	// Built on first access per container field and kept across assign()
+	// calls, so their position buffers are reused.
+	mutable std::vector<StructuralIndex> containerIndexes;
+	mutable std::vector<bool> indexedContainers;
+
+	std::size_t indexOf(std::string_view aKey) const
+	{
+		auto index = schema ? schema->indexOf(aKey) : ConvertableSchema::NotFound;
+		if (index == ConvertableSchema::NotFound || index >= fields.size())
+		{
+			CS::Errors::throwExceptionFieldNotFound(aKey);
+		}
+
+		return index;
+	}
+
+	const StructuralIndex& containerIndex(std::size_t aIndex, std::string_view aValues) const
+	{
+		if (!indexedContainers[aIndex])
+		{
+			containerIndexes[aIndex].build(aValues);
+			indexedContainers[aIndex] = true;
+		}
+
+		return containerIndexes[aIndex];
+	}
+
+	// Parts of a "type$inner$count$values" container field. The views walk the
+	// values themselves, the count only tells one empty element from none.
+	static CS::DataHelper::ContainerParts splitContainer(std::string_view aField, std::string_view aType)
+	{
+		CS::DataHelper::ContainerParts parts;
+		if (!CS::DataHelper::splitContainer(aField, parts))
+		{
+			CS::Errors::throwExceptionFailedToParse(aField, aType);
+		}
+
+		if (parts.type != aType)
+		{
+			CS::Errors::throwExceptionWithTypeMismatch(parts.type, aType);
+		}
+
+		return parts;
+	}
+
+	static bool isEmpty(const CS::DataHelper::ContainerParts& aParts) { return aParts.hasCount ? aParts.count == 0 : aParts.values.empty(); }
+};
+
+#endif // !__CS_LINE_SAVE_VIEW_H__
@@ -2,11 +2,21 @@
 #define __CS_VALUE_CONVERTER_H__
 
 #include "CSHelper.h"
+#include "CSStructuralIndex.h"
 
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+// Every converter also has a static tag and a constexpr signature(), the
+// "i$" or "m$s^i$" header its typed text starts with. Encoding appends it in
+// one go and decoding checks it with one compare; type() and typeOf are
+// there for runtime lookups and errors. castUncheckedInto skips the header
+// without looking at it, for records whose schema fingerprint matched.
 struct IValueConverter
 {
 	virtual const std::string& type() = 0;
-	virtual bool typeOf(const std::string& aTypeCheck) { return aTypeCheck == type(); }
+	virtual bool typeOf(std::string_view aTypeCheck) { return aTypeCheck == type(); }
 };
 
 template<typename Type, typename Definition = void>
@@ -15,34 +25,96 @@ struct ValueConverter {};
 // @ STRING CONVERTER @ 
 
 template<typename StringType>
-struct ValueConverter<StringType, CS::TypeHelper::isSame<StringType, std::string>> : public IValueConverter 
+struct ValueConverter<StringType, CS::TypeHelper::isString<StringType>> : public IValueConverter 
 {
+	static constexpr char tag = CSTypeDefines::csStringTag;
+	static constexpr std::string_view signature() { return CS::TypeHelper::Signature<tag>::view(); }
+
 	const std::string& type() override { return CSTypeDefines::csStringType;  }
 
-	StringType cast(const std::string& aValue)
+	StringType cast(std::string_view aValue)
+	{
+		return StringType(aValue);
+	}
+
+	StringType castTyped(std::string_view aValue)
+	{
+		StringType castedValue{};
+		castTypedInto(aValue, castedValue);
+		return castedValue;
+	}
+
+	// The *Into casts assign through the destination, so its allocator is kept.
+	void castInto(std::string_view aValue, StringType& aString) { aString.assign(aValue.data(), aValue.size()); }
+
+	void castTypedInto(std::string_view aValue, StringType& aString) { castInto(CS::TypeHelper::stripSignature(aValue, signature()), aString); }
+	void castUncheckedInto(std::string_view aValue, StringType& aString) { castInto(CS::TypeHelper::skipSignature(aValue, signature()), aString); }
+
+	// Non-throwing casts of ConvertableStruct::tryConvertLineSaveToObject.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, StringType& aString) { castInto(aValue, aString); return CSTypeDefines::DecodeStatus::Ok; }
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, StringType& aString) { return CS::TypeHelper::hasSignature(aValue, signature()) ? tryCastInto(aValue.substr(signature().size()), aString) : CSTypeDefines::DecodeStatus::TypeMismatch; }
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, StringType& aString) { return tryCastInto(CS::TypeHelper::skipSignature(aValue, signature()), aString); }
+
+	std::string toString(const StringType& aValue) { return std::string(aValue.data(), aValue.size()); }
+	std::string toTyped(const StringType& aValue)
+	{
+		std::string string;
+		string.reserve(typedSize(aValue));
+		appendTyped(string, aValue);
+		return string;
+	}
+
+	void appendString(std::string& aBuffer, const StringType& aValue) { aBuffer += aValue; }
+	std::size_t stringSize(const StringType& aValue) { return aValue.size(); }
+
+	void appendTyped(std::string& aBuffer, const StringType& aValue)
+	{
+		aBuffer += signature();
+		appendString(aBuffer, aValue);
+	}
+
+	std::size_t typedSize(const StringType& aValue) { return signature().size() + stringSize(aValue); }
+
+	void appendBinary(std::string& aBuffer, const StringType& aValue)
 	{
-		return aValue;
+		CS::BinaryHelper::appendVarint(aBuffer, aValue.size());
+		aBuffer += aValue;
 	}
 
-	StringType castTyped(const StringType& aValue)
+	std::size_t binarySize(const StringType& aValue) { return CS::BinaryHelper::varintSize(aValue.size()) + aValue.size(); }
+
+	StringType castBinary(std::string_view& aValue)
 	{
 		StringType castedValue{};
+		castBinaryInto(aValue, castedValue);
+		return castedValue;
+	}
 
-		auto [valueType, value] = CS::DataHelper::splitTwoValues(aValue, CSTypeDefines::csTypeDelimiter);
-		if (typeOf(valueType))
+	void castBinaryInto(std::string_view& aValue, StringType& aString) { CS::Errors::throwExceptionWithStatus(tryCastBinaryInto(aValue, aString), {}, type()); }
+
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, StringType& aString)
+	{
+		std::uint64_t size = 0;
+		if (!CS::BinaryHelper::tryReadVarint(aValue, size) || size > aValue.size())
 		{
-			castedValue = cast(value);
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
 		}
-		else
+
+		castInto(aValue.substr(0, static_cast<std::size_t>(size)), aString);
+		aValue.remove_prefix(static_cast<std::size_t>(size));
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+	void skipBinary(std::string_view& aValue)
+	{
+		auto size = CS::BinaryHelper::readVarint(aValue);
+		if (size > aValue.size())
 		{
-			CS::Errors::throwExceptionWithTypeMismatch(valueType, type());
+			CS::Errors::throwExceptionMalformedBinary(CS::TypeHelper::tryGetFullType(type()));
 		}
 
-		return castedValue;
+		aValue.remove_prefix(static_cast<std::size_t>(size));
 	}
-
-	std::string toString(const StringType& aValue) { return aValue; }
-	std::string toTyped(const StringType& aValue) { return CS::TypeHelper::typifyValue(type(), toString(aValue)); };
 };
 
 // @ INTEGRAL CONVERTER @ 
@@ -50,35 +122,144 @@ struct ValueConverter<StringType, CS::TypeHelper::isSame<StringType, std::string
 template<typename IntegralType>
 struct ValueConverter<IntegralType, CS::TypeHelper::isIntergal<IntegralType>> : public IValueConverter
 {
+	static constexpr char tag = CSTypeDefines::csIntegralTag;
+	static constexpr std::string_view signature() { return CS::TypeHelper::Signature<tag>::view(); }
+
 	const std::string& type() override { return CSTypeDefines::csIntegralType; }
 
-	IntegralType cast(const std::string& aValue)
+	IntegralType cast(std::string_view aValue)
 	{
 		IntegralType castedValue{};
-		std::stringstream ss(aValue);
-		ss >> castedValue;
+		if (tryCastInto(aValue, castedValue) != CSTypeDefines::DecodeStatus::Ok)
+		{
+			CS::Errors::throwExceptionFailedToParse(aValue, type());
+		}
+
 		return castedValue;
 	}
 
-	IntegralType castTyped(const std::string& aValue)
+	// Non-throwing casts of ConvertableStruct::tryConvertLineSaveToObject,
+	// aDestination is only written on success.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, IntegralType& aDestination)
+	{
+		IntegralType castedValue{};
+		const char* valueEnd = aValue.data() + aValue.size();
+
+		auto [end, error] = std::from_chars(aValue.data(), valueEnd, castedValue);
+		if (error != std::errc{} || end != valueEnd)
+		{
+			return CSTypeDefines::DecodeStatus::FailedToParse;
+		}
+
+		aDestination = castedValue;
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, IntegralType& aDestination) { return CS::TypeHelper::hasSignature(aValue, signature()) ? tryCastInto(aValue.substr(signature().size()), aDestination) : CSTypeDefines::DecodeStatus::TypeMismatch; }
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, IntegralType& aDestination) { return tryCastInto(CS::TypeHelper::skipSignature(aValue, signature()), aDestination); }
+
+	IntegralType castTyped(std::string_view aValue) { return cast(CS::TypeHelper::stripSignature(aValue, signature())); }
+
+	void castInto(std::string_view aValue, IntegralType& aDestination) { aDestination = cast(aValue); }
+	void castTypedInto(std::string_view aValue, IntegralType& aDestination) { aDestination = castTyped(aValue); }
+	void castUncheckedInto(std::string_view aValue, IntegralType& aDestination) { aDestination = cast(CS::TypeHelper::skipSignature(aValue, signature())); }
+
+	std::string toString(const IntegralType& aValue) 
+	{ 
+		std::string string;
+		appendString(string, aValue);
+		return string;
+	}
+
+	std::string toTyped(const IntegralType& aValue)
+	{
+		std::string string;
+		appendTyped(string, aValue);
+		return string;
+	}
+
+	void appendString(std::string& aBuffer, const IntegralType& aValue)
+	{
+		char digits[MaxDigits];
+		auto [end, error] = std::to_chars(digits, digits + MaxDigits, aValue);
+		aBuffer.append(digits, end);
+	}
+
+	std::size_t stringSize(const IntegralType& aValue)
+	{
+		char digits[MaxDigits];
+		auto [end, error] = std::to_chars(digits, digits + MaxDigits, aValue);
+		return static_cast<std::size_t>(end - digits);
+	}
+
+	void appendTyped(std::string& aBuffer, const IntegralType& aValue)
+	{
+		aBuffer += signature();
+		appendString(aBuffer, aValue);
+	}
+
+	std::size_t typedSize(const IntegralType& aValue) { return signature().size() + stringSize(aValue); }
+
+	void appendBinary(std::string& aBuffer, const IntegralType& aValue) { CS::BinaryHelper::appendVarint(aBuffer, toVarint(aValue)); }
+	std::size_t binarySize(const IntegralType& aValue) { return CS::BinaryHelper::varintSize(toVarint(aValue)); }
+
+	IntegralType castBinary(std::string_view& aValue)
 	{
 		IntegralType castedValue{};
+		castBinaryInto(aValue, castedValue);
+		return castedValue;
+	}
+
+	void castBinaryInto(std::string_view& aValue, IntegralType& aDestination) { CS::Errors::throwExceptionWithStatus(tryCastBinaryInto(aValue, aDestination), {}, type()); }
+
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, IntegralType& aDestination)
+	{
+		std::uint64_t varint = 0;
+		if (!CS::BinaryHelper::tryReadVarint(aValue, varint))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
 
-		auto [valueType, value] = CS::DataHelper::splitTwoValues(aValue, CSTypeDefines::csTypeDelimiter);
-		if (typeOf(valueType))
+		if constexpr (std::is_signed_v<IntegralType>)
 		{
-			castedValue = cast(value);
+			auto value = CS::BinaryHelper::zigZagDecode(varint);
+			if (value < std::numeric_limits<IntegralType>::min() || value > std::numeric_limits<IntegralType>::max())
+			{
+				return CSTypeDefines::DecodeStatus::MalformedBinary;
+			}
+
+			aDestination = static_cast<IntegralType>(value);
 		}
 		else
 		{
-			CS::Errors::throwExceptionWithTypeMismatch(valueType, type());
+			if (varint > std::numeric_limits<IntegralType>::max())
+			{
+				return CSTypeDefines::DecodeStatus::MalformedBinary;
+			}
+
+			aDestination = static_cast<IntegralType>(varint);
 		}
 
-		return castedValue;
+		return CSTypeDefines::DecodeStatus::Ok;
 	}
 
-	std::string toString(const IntegralType& aValue) { return std::to_string(aValue); }
-	std::string toTyped(const IntegralType& aValue) { return CS::TypeHelper::typifyValue(type(), toString(aValue)); };
+	void skipBinary(std::string_view& aValue) { CS::BinaryHelper::readVarint(aValue); }
+
+private:
+	// Sign plus every decimal digit of the type.
+	static constexpr std::size_t MaxDigits = std::numeric_limits<IntegralType>::digits10 + 2;
+
+	static std::uint64_t toVarint(IntegralType aValue)
+	{
+		if constexpr (std::is_signed_v<IntegralType>)
+		{
+			return CS::BinaryHelper::zigZagEncode(aValue);
+		}
+		else
+		{
+			return aValue;
+		}
+	}
 };
 
 // @ FLOATING CONVERTER @ 
@@ -86,35 +267,95 @@ struct ValueConverter<IntegralType, CS::TypeHelper::isIntergal<IntegralType>> :
 template<typename FloatingType>
 struct ValueConverter<FloatingType, CS::TypeHelper::isFloating<FloatingType>> : public IValueConverter
 {
+	static constexpr char tag = CSTypeDefines::csFloatingTag;
+	static constexpr std::string_view signature() { return CS::TypeHelper::Signature<tag>::view(); }
+
 	const std::string& type() override { return CSTypeDefines::csFloatingType; }
 	
-	FloatingType cast(const std::string& aValue)
+	FloatingType cast(std::string_view aValue)
 	{
 		FloatingType castedValue{};
-		std::stringstream ss(aValue);
-		ss >> castedValue;
+		if (tryCastInto(aValue, castedValue) != CSTypeDefines::DecodeStatus::Ok)
+		{
+			CS::Errors::throwExceptionFailedToParse(aValue, type());
+		}
+
 		return castedValue;
 	}
 
-	FloatingType castTyped(const std::string& aValue)
+	// Non-throwing casts of ConvertableStruct::tryConvertLineSaveToObject,
+	// aDestination is only written on success.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, FloatingType& aDestination)
 	{
 		FloatingType castedValue{};
+		const char* valueEnd = aValue.data() + aValue.size();
 
-		auto [valueType, value] = CS::DataHelper::splitTwoValues(aValue, CSTypeDefines::csTypeDelimiter);
-		if (typeOf(valueType))
-		{
-			castedValue = cast(value);
-		}
-		else
+		auto [end, error] = std::from_chars(aValue.data(), valueEnd, castedValue);
+		if (error != std::errc{} || end != valueEnd)
 		{
-			CS::Errors::throwExceptionWithTypeMismatch(valueType, type());
+			return CSTypeDefines::DecodeStatus::FailedToParse;
 		}
 
-		return castedValue;
+		aDestination = castedValue;
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, FloatingType& aDestination) { return CS::TypeHelper::hasSignature(aValue, signature()) ? tryCastInto(aValue.substr(signature().size()), aDestination) : CSTypeDefines::DecodeStatus::TypeMismatch; }
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, FloatingType& aDestination) { return tryCastInto(CS::TypeHelper::skipSignature(aValue, signature()), aDestination); }
+
+	FloatingType castTyped(std::string_view aValue) { return cast(CS::TypeHelper::stripSignature(aValue, signature())); }
+
+	void castInto(std::string_view aValue, FloatingType& aDestination) { aDestination = cast(aValue); }
+	void castTypedInto(std::string_view aValue, FloatingType& aDestination) { aDestination = castTyped(aValue); }
+	void castUncheckedInto(std::string_view aValue, FloatingType& aDestination) { aDestination = cast(CS::TypeHelper::skipSignature(aValue, signature())); }
+
+	std::string toString(const FloatingType& aValue) 
+	{ 
+		std::string string;
+		appendString(string, aValue);
+		return string;
+	}
+
+	std::string toTyped(const FloatingType& aValue)
+	{
+		std::string string;
+		appendTyped(string, aValue);
+		return string;
+	}
+
+	// Shortest text that parses back to the exact same value.
+	void appendString(std::string& aBuffer, const FloatingType& aValue)
+	{
+		char digits[MaxDigits];
+		auto [end, error] = std::to_chars(digits, digits + MaxDigits, aValue);
+		aBuffer.append(digits, end);
+	}
+
+	std::size_t stringSize(const FloatingType& aValue)
+	{
+		char digits[MaxDigits];
+		auto [end, error] = std::to_chars(digits, digits + MaxDigits, aValue);
+		return static_cast<std::size_t>(end - digits);
+	}
+
+	void appendTyped(std::string& aBuffer, const FloatingType& aValue)
+	{
+		aBuffer += signature();
+		appendString(aBuffer, aValue);
 	}
 
-	std::string toString(const FloatingType& aValue) { return std::to_string(aValue); }
-	std::string toStringTyped(const FloatingType& aValue) { return CS::TypeHelper::typifyValue(type(), aValue); }
+	std::size_t typedSize(const FloatingType& aValue) { return signature().size() + stringSize(aValue); }
+
+	void appendBinary(std::string& aBuffer, const FloatingType& aValue) { CS::BinaryHelper::appendRaw(aBuffer, aValue); }
+	std::size_t binarySize(const FloatingType&) { return sizeof(FloatingType); }
+	FloatingType castBinary(std::string_view& aValue) { return CS::BinaryHelper::readRaw<FloatingType>(aValue); }
+	void castBinaryInto(std::string_view& aValue, FloatingType& aDestination) { aDestination = castBinary(aValue); }
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, FloatingType& aDestination) { return CS::BinaryHelper::tryReadRaw(aValue, aDestination) ? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::MalformedBinary; }
+	void skipBinary(std::string_view& aValue) { CS::BinaryHelper::readBytes(aValue, sizeof(FloatingType)); }
+
+private:
+	// Enough for the longest shortest-round-trip form of any floating type.
+	static constexpr std::size_t MaxDigits = 64;
 };
 
 // @ BOOL CONVERTER @ 
@@ -122,32 +363,63 @@ struct ValueConverter<FloatingType, CS::TypeHelper::isFloating<FloatingType>> :
 template<typename BoolType>
 struct ValueConverter<BoolType, CS::TypeHelper::isSame<BoolType, bool>> : public IValueConverter
 {
-	const std::string& type() override { return CSTypeDefines::csFloatingType; }
+	static constexpr char tag = CSTypeDefines::csBoolTag;
+	static constexpr std::string_view signature() { return CS::TypeHelper::Signature<tag>::view(); }
+
+	const std::string& type() override { return CSTypeDefines::csBoolType; }
 	
-	BoolType cast(const std::string& aValue)
+	BoolType cast(std::string_view aValue)
 	{
 		return aValue == "+" ? true : false;
 	}
 
-	BoolType castTyped(const std::string& aValue)
+	BoolType castTyped(std::string_view aValue) { return cast(CS::TypeHelper::stripSignature(aValue, signature())); }
+
+	void castInto(std::string_view aValue, BoolType& aDestination) { aDestination = cast(aValue); }
+	void castTypedInto(std::string_view aValue, BoolType& aDestination) { aDestination = castTyped(aValue); }
+	void castUncheckedInto(std::string_view aValue, BoolType& aDestination) { aDestination = cast(CS::TypeHelper::skipSignature(aValue, signature())); }
+
+	// Non-throwing casts of ConvertableStruct::tryConvertLineSaveToObject.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, BoolType& aDestination) { castInto(aValue, aDestination); return CSTypeDefines::DecodeStatus::Ok; }
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, BoolType& aDestination) { return CS::TypeHelper::hasSignature(aValue, signature()) ? tryCastInto(aValue.substr(signature().size()), aDestination) : CSTypeDefines::DecodeStatus::TypeMismatch; }
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, BoolType& aDestination) { return tryCastInto(CS::TypeHelper::skipSignature(aValue, signature()), aDestination); }
+
+	std::string toString(const BoolType& aValue) { return aValue ? "+" : "-"; }
+	std::string toTyped(const BoolType& aValue)
 	{
-		BoolType castedValue{};
+		std::string string;
+		appendTyped(string, aValue);
+		return string;
+	}
 
-		auto [valueType, value] = CS::DataHelper::splitTwoValues(aValue, CSTypeDefines::csTypeDelimiter);
-		if (typeOf(valueType))
-		{
-			castedValue = cast(value);
-		}
-		else
+	void appendString(std::string& aBuffer, const BoolType& aValue) { aBuffer += aValue ? '+' : '-'; }
+	std::size_t stringSize(const BoolType& aValue) { return 1; }
+
+	void appendTyped(std::string& aBuffer, const BoolType& aValue)
+	{
+		aBuffer += signature();
+		appendString(aBuffer, aValue);
+	}
+
+	std::size_t typedSize(const BoolType& aValue) { return signature().size() + stringSize(aValue); }
+
+	void appendBinary(std::string& aBuffer, const BoolType& aValue) { aBuffer += aValue ? '\1' : '\0'; }
+	std::size_t binarySize(const BoolType&) { return 1; }
+	BoolType castBinary(std::string_view& aValue) { return CS::BinaryHelper::readBytes(aValue, 1)[0] != '\0'; }
+	void castBinaryInto(std::string_view& aValue, BoolType& aDestination) { aDestination = castBinary(aValue); }
+
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, BoolType& aDestination)
+	{
+		std::string_view byte;
+		if (!CS::BinaryHelper::tryReadBytes(aValue, 1, byte))
 		{
-			CS::Errors::throwExceptionWithTypeMismatch(valueType, type());
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
 		}
 
-		return castedValue;
+		aDestination = byte[0] != '\0';
+		return CSTypeDefines::DecodeStatus::Ok;
 	}
-	
-	std::string toString(const BoolType& aValue) { return aValue ? "+" : "-"; }
-	std::string toTyped(const BoolType& aValue) { return CS::TypeHelper::typifyValue(type(), toString(aValue)); }
+	void skipBinary(std::string_view& aValue) { CS::BinaryHelper::readBytes(aValue, 1); }
 };
 
 // @ ENUM CONVERTER @ 
@@ -157,209 +429,1524 @@ struct ValueConverter<EnumType, CS::TypeHelper::isEnum<EnumType>> : public IValu
 {
 	using EnumUnderlyingType = typename std::underlying_type<EnumType>::type;
 
+	static constexpr char tag = CSTypeDefines::csIntegralTag;
+	static constexpr std::string_view signature() { return CS::TypeHelper::Signature<tag>::view(); }
+
 	const std::string& type() override { return CSTypeDefines::csIntegralType; }
 
-	EnumType cast(const std::string& aValue)
+	EnumType cast(std::string_view aValue)
 	{
 		ValueConverter<EnumUnderlyingType> converter;
 		return static_cast<EnumType>(converter.cast(aValue));
 	}
 
-	EnumType castTyped(const std::string& aValue)
+	EnumType castTyped(std::string_view aValue) { return cast(CS::TypeHelper::stripSignature(aValue, signature())); }
+
+	void castInto(std::string_view aValue, EnumType& aDestination) { aDestination = cast(aValue); }
+	void castTypedInto(std::string_view aValue, EnumType& aDestination) { aDestination = castTyped(aValue); }
+	void castUncheckedInto(std::string_view aValue, EnumType& aDestination) { aDestination = cast(CS::TypeHelper::skipSignature(aValue, signature())); }
+
+	// Non-throwing casts of ConvertableStruct::tryConvertLineSaveToObject.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, EnumType& aDestination)
 	{
-		EnumType castedValue{};
+		ValueConverter<EnumUnderlyingType> converter;
+		EnumUnderlyingType castedValue{};
 
-		auto [valueType, value] = CS::DataHelper::splitTwoValues(aValue, CSTypeDefines::csTypeDelimiter);
-		if (typeOf(valueType))
+		auto status = converter.tryCastInto(aValue, castedValue);
+		if (status == CSTypeDefines::DecodeStatus::Ok)
 		{
-			castedValue = cast(value);
-		}
-		else
-		{
-			CS::Errors::throwExceptionWithTypeMismatch(valueType, type());
+			aDestination = static_cast<EnumType>(castedValue);
 		}
 
-		return castedValue;
+		return status;
 	}
 
-	std::string toString(const EnumType& aValue) { return std::to_string(static_cast<EnumUnderlyingType>(aValue)); }
-	std::string toTyped(const EnumType& aValue) { return CS::TypeHelper::typifyValue(type(), toString(aValue)); }
-};
-
-// @ VECTOR CONVERTER @ 
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, EnumType& aDestination) { return CS::TypeHelper::hasSignature(aValue, signature()) ? tryCastInto(aValue.substr(signature().size()), aDestination) : CSTypeDefines::DecodeStatus::TypeMismatch; }
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, EnumType& aDestination) { return tryCastInto(CS::TypeHelper::skipSignature(aValue, signature()), aDestination); }
 
-template<typename VectorType>
-struct ValueConverter<VectorType, CS::TypeHelper::isSame<VectorType, std::vector<typename VectorType::value_type>>> : public IValueConverter
-{
-	using ValueType = typename VectorType::value_type;
+	std::string toString(const EnumType& aValue) 
+	{ 
+		ValueConverter<EnumUnderlyingType> converter;
+		return converter.toString(static_cast<EnumUnderlyingType>(aValue));
+	}
 
-	const std::string& type() override { return CSTypeDefines::csVectorType; }
+	std::string toTyped(const EnumType& aValue)
+	{
+		std::string string;
+		appendTyped(string, aValue);
+		return string;
+	}
 
-	VectorType cast(const std::string& aValue)
+	void appendString(std::string& aBuffer, const EnumType& aValue)
 	{
-		VectorType casteValue{};
-		
-		auto splittedValues = CS::DataHelper::splitString(aValue, CSTypeDefines::csContainerValuesDelimiter);
-		if (!splittedValues.empty())
-		{
-			ValueConverter<ValueType> valueConverter;
-			for (auto& value : splittedValues)
-			{
-				casteValue.push_back(valueConverter.cast(value));
-			}
-		}
+		ValueConverter<EnumUnderlyingType> converter;
+		converter.appendString(aBuffer, static_cast<EnumUnderlyingType>(aValue));
+	}
 
-		return casteValue;
+	std::size_t stringSize(const EnumType& aValue)
+	{
+		ValueConverter<EnumUnderlyingType> converter;
+		return converter.stringSize(static_cast<EnumUnderlyingType>(aValue));
 	}
 
-	VectorType castTyped(const std::string& aValue)
+	void appendTyped(std::string& aBuffer, const EnumType& aValue)
 	{
-		VectorType casteValue{};
+		aBuffer += signature();
+		appendString(aBuffer, aValue);
+	}
 
-		auto splittedValues = CS::DataHelper::splitString(aValue, CSTypeDefines::csTypeDelimiter);
-		if (splittedValues.size() == 3)
-		{
-			const auto& vectorType = splittedValues[0];
-			const auto& innerType = splittedValues[1];
-			const auto& vectorValues = splittedValues[2];
+	std::size_t typedSize(const EnumType& aValue) { return signature().size() + stringSize(aValue); }
 
-			if (typeOf(vectorType))
-			{
-				ValueConverter<ValueType> valueConverter;
-				if (!valueConverter.typeOf(innerType))
-				{
-					CS::Errors::throwExceptionWithTypeMismatch(innerType, type());
-				}
+	void appendBinary(std::string& aBuffer, const EnumType& aValue)
+	{
+		ValueConverter<EnumUnderlyingType> converter;
+		converter.appendBinary(aBuffer, static_cast<EnumUnderlyingType>(aValue));
+	}
 
-				casteValue = cast(vectorValues);
-			}
-			else
-			{
-				CS::Errors::throwExceptionWithTypeMismatch(vectorType, type());
-			}
-		}
+	std::size_t binarySize(const EnumType& aValue)
+	{
+		ValueConverter<EnumUnderlyingType> converter;
+		return converter.binarySize(static_cast<EnumUnderlyingType>(aValue));
+	}
 
-		return casteValue;
+	EnumType castBinary(std::string_view& aValue)
+	{
+		ValueConverter<EnumUnderlyingType> converter;
+		return static_cast<EnumType>(converter.castBinary(aValue));
 	}
 
-	std::string toString(const VectorType& aValue) 
-	{ 
-		std::string string;
+	void castBinaryInto(std::string_view& aValue, EnumType& aDestination) { aDestination = castBinary(aValue); }
 
-		if (!aValue.empty())
-		{
-			ValueConverter<ValueType> valueConverter;
-			auto valuesAmount = aValue.size();
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, EnumType& aDestination)
+	{
+		ValueConverter<EnumUnderlyingType> converter;
+		EnumUnderlyingType castedValue{};
 
-			for (auto& value : aValue)
-			{
-				string += valueConverter.toString(value);
-				if (--valuesAmount != 0) 
-				{
-					string += CSTypeDefines::csContainerValuesDelimiter;
-				}
-			}
+		auto status = converter.tryCastBinaryInto(aValue, castedValue);
+		if (status == CSTypeDefines::DecodeStatus::Ok)
+		{
+			aDestination = static_cast<EnumType>(castedValue);
 		}
 
-		return string;
+		return status;
 	}
 
-	std::string toTyped(const VectorType& aValue) 
-	{ 
-		ValueConverter<ValueType> valueConverter;
-		std::string formatedType = CS::TypeHelper::formatType({ type(), valueConverter.type() });
-		return CS::TypeHelper::typifyValue(std::move(formatedType), toString(aValue));
+	void skipBinary(std::string_view& aValue)
+	{
+		ValueConverter<EnumUnderlyingType> converter;
+		converter.skipBinary(aValue);
 	}
 };
 
-// @ PAIR CONVERTER @ 
+// @ PACKED NUMBERS @ 
 
-template<typename PairType>
-struct ValueConverter<PairType, CS::TypeHelper::isPair<PairType>> : public IValueConverter
+// Runs of numbers for the vector and array converters. Text is printed into
+// a local chunk and parsed in one pass over the values, with no split or call
+// per element. Binary is the count followed by one raw little-endian block.
+template<typename NumberType>
+struct PackedNumbers
 {
-	using FirstType = typename PairType::first_type;
-	using SecondType = typename PairType::second_type;
-
-	virtual const std::string& type() override { return CSTypeDefines::csPairType; };
-
-	PairType cast(const std::string& aValue)
+	static void appendString(std::string& aBuffer, const NumberType* aValues, std::size_t aCount)
 	{
-		const auto [firstValue, secondValue] = CS::DataHelper::splitTwoValues(aValue, CSTypeDefines::csContainerValuesDelimiter);
+		char chunk[ChunkSize];
+		char* chunkEnd = chunk;
+		for (std::size_t index = 0; index < aCount; ++index)
+		{
+			if (chunkEnd + MaxDigits + 1 > chunk + ChunkSize)
+			{
+				aBuffer.append(chunk, chunkEnd);
+				chunkEnd = chunk;
+			}
 
-		ValueConverter<FirstType> firstValueConverter;
-		ValueConverter<SecondType> secondValueConverter;
+			if (index != 0)
+			{
+				*chunkEnd++ = CSTypeDefines::csContainerValuesDelimiter.front();
+			}
 
-		return { firstValueConverter.cast(firstValue), secondValueConverter.cast(secondValue) };
+			chunkEnd = std::to_chars(chunkEnd, chunk + ChunkSize, aValues[index]).ptr;
+		}
+
+		aBuffer.append(chunk, chunkEnd);
 	}
 
-	PairType castTyped(const std::string& aValue)
+	// Parses the "1^2^3" numbers of aValues and passes each to aStore along with
+	// its index. aAmount is set to the amount of numbers read.
+	template<typename Store>
+	static CSTypeDefines::DecodeStatus tryCastString(std::string_view aValues, std::size_t& aAmount, Store&& aStore)
 	{
-		PairType casteValue{};
-
-		auto splitedMapData = CS::DataHelper::splitString(aValue, CSTypeDefines::csTypeDelimiter);
-		
-		const auto& pairType = splitedMapData[0];
-		const auto& pairInnerType = splitedMapData[1];
-		const auto& pairValue = splitedMapData[2];
+		aAmount = 0;
+		if (aValues.empty())
+		{
+			return CSTypeDefines::DecodeStatus::Ok;
+		}
 
-		if (!pairType.empty() && !pairInnerType.empty() && !pairValue.empty())
+		const char* position = aValues.data();
+		const char* valuesEnd = position + aValues.size();
+		while (true)
 		{
-			if (pairType == type())
+			NumberType value{};
+			auto [end, error] = std::from_chars(position, valuesEnd, value);
+			if (error != std::errc{} || (end != valuesEnd && *end != CSTypeDefines::csContainerValuesDelimiter.front()))
 			{
-				ValueConverter<FirstType> firstValueConverter;
-				ValueConverter<SecondType> secondValueConverter;
-
-				auto [firstType, secondType] = CS::DataHelper::splitTwoValues(pairInnerType, CSTypeDefines::csContainerValuesDelimiter);
-				if (!firstValueConverter.typeOf(firstType))
-				{
-					CS::Errors::throwExceptionWithTypeMismatch(firstType, firstValueConverter.type());
-				}
-
-				if (!secondValueConverter.typeOf(secondType))
-				{
-					CS::Errors::throwExceptionWithTypeMismatch(secondType, secondValueConverter.type());
-				}
-
-				casteValue = cast(pairValue);
+				return CSTypeDefines::DecodeStatus::FailedToParse;
 			}
-			else
+
+			aStore(aAmount++, value);
+			if (end == valuesEnd)
 			{
-				CS::Errors::throwExceptionWithTypeMismatch(pairType, type());
+				return CSTypeDefines::DecodeStatus::Ok;
 			}
-		}
 
-		return casteValue;
+			position = end + 1;
+		}
+	}
+
+	static void appendBinary(std::string& aBuffer, const NumberType* aValues, std::size_t aCount)
+	{
+		CS::BinaryHelper::appendVarint(aBuffer, aCount);
+		CS::BinaryHelper::appendRawBlock(aBuffer, aValues, aCount);
+	}
+
+	static std::size_t binarySize(std::size_t aCount) { return CS::BinaryHelper::varintSize(aCount) + aCount * sizeof(NumberType); }
+
+	// Reads the count of a block and checks that the input holds it.
+	static std::size_t readBinaryCount(std::string_view& aValue, std::string_view aType)
+	{
+		std::size_t valuesAmount = 0;
+		CS::Errors::throwExceptionWithStatus(tryReadBinaryCount(aValue, valuesAmount), {}, aType);
+		return valuesAmount;
+	}
+
+	static CSTypeDefines::DecodeStatus tryReadBinaryCount(std::string_view& aValue, std::size_t& aAmount)
+	{
+		std::uint64_t valuesAmount = 0;
+		if (!CS::BinaryHelper::tryReadVarint(aValue, valuesAmount))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+		else if (valuesAmount > CS::Limits::maxVectorElements)
+		{
+			return CSTypeDefines::DecodeStatus::CountOverLimit;
+		}
+		else if (valuesAmount > aValue.size() / sizeof(NumberType))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+
+		aAmount = static_cast<std::size_t>(valuesAmount);
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+private:
+	// Sign and digits of any integer, or the longest shortest form of a float.
+	static constexpr std::size_t MaxDigits = std::is_floating_point_v<NumberType> ? 32 : std::numeric_limits<NumberType>::digits10 + 2;
+	static constexpr std::size_t ChunkSize = 4096;
+};
+
+// @ VECTOR CONVERTER @ 
+
+template<typename VectorType>
+struct ValueConverter<VectorType, CS::TypeHelper::isVector<VectorType>> : public IValueConverter
+{
+	using ValueType = typename VectorType::value_type;
+
+	static constexpr char tag = CSTypeDefines::csVectorTag;
+	static constexpr std::string_view signature() { return CS::TypeHelper::Signature<tag, ValueConverter<ValueType>::tag>::view(); }
+
+	const std::string& type() override { return CSTypeDefines::csVectorType; }
+
+	VectorType cast(std::string_view aValue)
+	{
+		VectorType casteValue{};
+		castInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	VectorType castTyped(std::string_view aValue)
+	{
+		VectorType casteValue{};
+		castTypedInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	// Replaces the elements of aVector. Existing elements are decoded over, so
+	// its capacity and theirs is reused; new ones are built with its allocator.
+	void castInto(std::string_view aValue, VectorType& aVector) { CS::Errors::throwExceptionWithStatus(tryCastInto(aValue, aVector), aValue, type()); }
+
+	void castTypedInto(std::string_view aValue, VectorType& aVector, const StructuralIndex* aIndex = nullptr)
+	{
+		CS::Errors::throwExceptionWithStatus(tryCastTypedInto(aValue, aVector, aIndex), aValue, type());
+	}
+
+	void castUncheckedInto(std::string_view aValue, VectorType& aVector, const StructuralIndex* aIndex = nullptr)
+	{
+		CS::Errors::throwExceptionWithStatus(tryCastUncheckedInto(aValue, aVector, aIndex), aValue, type());
+	}
+
+	void castCountedInto(std::string_view aValue, VectorType& aVector, const StructuralIndex* aIndex = nullptr)
+	{
+		CS::Errors::throwExceptionWithStatus(tryCastCountedInto(aValue, aVector, aIndex), aValue, type());
+	}
+
+	// Non-throwing casts, the ones above throw what these return.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, VectorType& aVector) { return castValues(aValue, !aValue.empty(), aVector); }
+
+	// A counted value reserves its elements up front. The count also tells
+	// a single empty string apart from no elements. With aIndex, built over
+	// the line save aValue lies in, the elements are cut from its positions.
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, VectorType& aVector, const StructuralIndex* aIndex = nullptr)
+	{
+		if (!CS::TypeHelper::hasSignature(aValue, signature()))
+		{
+			// Not our header: a value that is not a container clears, any other type mismatches.
+			std::string_view valueType;
+			std::string_view innerTypes;
+			if (!CS::DataHelper::splitContainerHeader(aValue, valueType, innerTypes))
+			{
+				aVector.clear();
+				return CSTypeDefines::DecodeStatus::Ok;
+			}
+
+			return CSTypeDefines::DecodeStatus::TypeMismatch;
+		}
+
+		return tryCastCountedInto(aValue.substr(signature().size()), aVector, aIndex);
+	}
+
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, VectorType& aVector, const StructuralIndex* aIndex = nullptr)
+	{
+		return tryCastCountedInto(CS::TypeHelper::skipSignature(aValue, signature()), aVector, aIndex);
+	}
+
+	// The typed text without its header, "count$values".
+	CSTypeDefines::DecodeStatus tryCastCountedInto(std::string_view aValue, VectorType& aVector, const StructuralIndex* aIndex = nullptr)
+	{
+		CS::DataHelper::ContainerParts parts;
+		if (!CS::DataHelper::trySplitCounted(aValue, signature(), parts))
+		{
+			return CSTypeDefines::DecodeStatus::FailedToParse;
+		}
+
+		return castParts(parts, aVector, aIndex);
+	}
+
+	// castTypedInto split at the elements for LineSaveParser: the count once
+	// the header is read, every element as it arrives, then the amount read.
+	// Nothing is reserved from the count, which is only compared at the end,
+	// so a header alone cannot make the parser allocate.
+	void beginElements(std::size_t aCount, bool aHasCount)
+	{
+		if (aHasCount)
+		{
+			CS::Limits::checkCount(aCount, CS::Limits::maxVectorElements, type());
+		}
+	}
+
+	void castElementInto(std::string_view aElement, std::size_t aIndex, VectorType& aVector)
+	{
+		CS::Limits::checkCount(aIndex + 1, CS::Limits::maxVectorElements, type());
+
+		ValueConverter<ValueType> valueConverter;
+		auto status = castElement(aVector, aIndex, [&valueConverter, aElement](ValueType& aDestination) { return valueConverter.tryCastInto(aElement, aDestination); });
+		CS::Errors::throwExceptionWithStatus(status, aElement, valueConverter.type());
+	}
+
+	void endElements(std::size_t aAmount, std::size_t aCount, bool aHasCount, VectorType& aVector)
+	{
+		aVector.erase(aVector.begin() + static_cast<std::ptrdiff_t>(aAmount), aVector.end());
+
+		if (aHasCount && aAmount != aCount)
+		{
+			CS::Errors::throwExceptionFailedToParse(std::to_string(aCount), type());
+		}
+	}
+
+	std::string toString(const VectorType& aValue) 
+	{ 
+		std::string string;
+		string.reserve(stringSize(aValue));
+		appendString(string, aValue);
+		return string;
+	}
+
+	std::string toTyped(const VectorType& aValue) 
+	{ 
+		std::string string;
+		string.reserve(typedSize(aValue));
+		appendTyped(string, aValue);
+		return string;
+	}
+
+	void appendString(std::string& aBuffer, const VectorType& aValue)
+	{
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			PackedNumbers<ValueType>::appendString(aBuffer, aValue.data(), aValue.size());
+			return;
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		auto valuesAmount = aValue.size();
+
+		for (auto& value : aValue)
+		{
+			valueConverter.appendString(aBuffer, value);
+			if (--valuesAmount != 0)
+			{
+				aBuffer += CSTypeDefines::csContainerValuesDelimiter;
+			}
+		}
+	}
+
+	std::size_t stringSize(const VectorType& aValue)
+	{
+		std::size_t size = 0;
+		if (!aValue.empty())
+		{
+			ValueConverter<ValueType> valueConverter;
+			for (auto& value : aValue)
+			{
+				size += valueConverter.stringSize(value);
+			}
+
+			size += (aValue.size() - 1) * CSTypeDefines::csContainerValuesDelimiter.size();
+		}
+
+		return size;
+	}
+
+	void appendTyped(std::string& aBuffer, const VectorType& aValue)
+	{
+		aBuffer += signature();
+		CS::TypeHelper::appendContainerCount(aBuffer, aValue.size());
+		appendString(aBuffer, aValue);
+	}
+
+	std::size_t typedSize(const VectorType& aValue) { return signature().size() + CS::TypeHelper::containerCountSize(aValue.size()) + stringSize(aValue); }
+
+	// Element count, then the elements, or one block of them for numbers.
+	void appendBinary(std::string& aBuffer, const VectorType& aValue)
+	{
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			PackedNumbers<ValueType>::appendBinary(aBuffer, aValue.data(), aValue.size());
+			return;
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		CS::BinaryHelper::appendVarint(aBuffer, aValue.size());
+		for (auto& value : aValue)
+		{
+			valueConverter.appendBinary(aBuffer, value);
+		}
+	}
+
+	std::size_t binarySize(const VectorType& aValue)
+	{
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			return PackedNumbers<ValueType>::binarySize(aValue.size());
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		std::size_t size = CS::BinaryHelper::varintSize(aValue.size());
+		for (auto& value : aValue)
+		{
+			size += valueConverter.binarySize(value);
+		}
+
+		return size;
+	}
+
+	VectorType castBinary(std::string_view& aValue)
+	{
+		VectorType casteValue{};
+		castBinaryInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	void castBinaryInto(std::string_view& aValue, VectorType& aVector) { CS::Errors::throwExceptionWithStatus(tryCastBinaryInto(aValue, aVector), {}, type()); }
+
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, VectorType& aVector)
+	{
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			std::size_t valuesAmount = 0;
+			auto status = PackedNumbers<ValueType>::tryReadBinaryCount(aValue, valuesAmount);
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+
+			aVector.resize(valuesAmount);
+			return CS::BinaryHelper::tryReadRawBlock(aValue, aVector.data(), aVector.size()) ? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+
+		std::uint64_t valuesAmount = 0;
+		if (!CS::BinaryHelper::tryReadVarint(aValue, valuesAmount))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+		else if (valuesAmount > CS::Limits::maxVectorElements)
+		{
+			return CSTypeDefines::DecodeStatus::CountOverLimit;
+		}
+		else if (valuesAmount > aValue.size())
+		{
+			// Every element takes at least one byte.
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		aVector.reserve(static_cast<std::size_t>(valuesAmount));
+		for (std::size_t index = 0; index < valuesAmount; ++index)
+		{
+			auto status = castElement(aVector, index, [&valueConverter, &aValue](ValueType& aElement) { return valueConverter.tryCastBinaryInto(aValue, aElement); });
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+		}
+
+		aVector.erase(aVector.begin() + static_cast<std::ptrdiff_t>(valuesAmount), aVector.end());
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+	void skipBinary(std::string_view& aValue)
+	{
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			auto valuesAmount = PackedNumbers<ValueType>::readBinaryCount(aValue, type());
+			CS::BinaryHelper::readBytes(aValue, valuesAmount * sizeof(ValueType));
+			return;
+		}
+
+		auto valuesAmount = CS::BinaryHelper::readVarint(aValue);
+		if (valuesAmount > aValue.size())
+		{
+			CS::Errors::throwExceptionMalformedBinary(CS::TypeHelper::tryGetFullType(type()));
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		for (std::uint64_t index = 0; index < valuesAmount; ++index)
+		{
+			valueConverter.skipBinary(aValue);
+		}
+	}
+
+private:
+	CSTypeDefines::DecodeStatus castParts(const CS::DataHelper::ContainerParts& aParts, VectorType& aVector, const StructuralIndex* aIndex)
+	{
+		if (!aParts.hasCount)
+		{
+			return castValues(aParts.values, !aParts.values.empty(), aVector, aIndex);
+		}
+		else if (aParts.count > CS::Limits::maxVectorElements)
+		{
+			return CSTypeDefines::DecodeStatus::CountOverLimit;
+		}
+
+		aVector.reserve(aParts.count);
+		auto status = castValues(aParts.values, aParts.count != 0 || !aParts.values.empty(), aVector, aIndex);
+		if (status == CSTypeDefines::DecodeStatus::Ok && aVector.size() != aParts.count)
+		{
+			return CSTypeDefines::DecodeStatus::FailedToParse;
+		}
+
+		return status;
+	}
+
+	// Leaves aVector partly decoded when an element fails.
+	CSTypeDefines::DecodeStatus castValues(std::string_view aValues, bool aHasValues, VectorType& aVector, const StructuralIndex* aIndex = nullptr)
+	{
+		std::size_t valuesAmount = 0;
+
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			auto status = PackedNumbers<ValueType>::tryCastString(aValues, valuesAmount, [&aVector](std::size_t aIndex, ValueType aNumber)
+			{
+				if (aIndex < aVector.size())
+				{
+					aVector[aIndex] = aNumber;
+				}
+				else
+				{
+					aVector.push_back(aNumber);
+				}
+			});
+
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+		}
+		else if (aHasValues)
+		{
+			ValueConverter<ValueType> valueConverter;
+			auto castValue = [&aVector, &valuesAmount, &valueConverter](std::string_view aValue)
+			{
+				return castElement(aVector, valuesAmount++, [&valueConverter, aValue](ValueType& aElement) { return valueConverter.tryCastInto(aValue, aElement); });
+			};
+
+			if (aIndex)
+			{
+				for (auto value : aIndex->split(aValues, CSTypeDefines::csContainerValuesDelimiter))
+				{
+					auto status = castValue(value);
+					if (status != CSTypeDefines::DecodeStatus::Ok)
+					{
+						return status;
+					}
+				}
+			}
+			else
+			{
+				for (auto value : CS::DataHelper::split(aValues, CSTypeDefines::csContainerValuesDelimiter))
+				{
+					auto status = castValue(value);
+					if (status != CSTypeDefines::DecodeStatus::Ok)
+					{
+						return status;
+					}
+				}
+			}
+		}
+
+		aVector.erase(aVector.begin() + static_cast<std::ptrdiff_t>(valuesAmount), aVector.end());
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+	// Decodes over the element at aIndex, or appends a new one when the vector
+	// is shorter. Returns the status of aCast, a failed new element is dropped.
+	template<typename Cast>
+	static CSTypeDefines::DecodeStatus castElement(VectorType& aVector, std::size_t aIndex, Cast&& aCast)
+	{
+		if (aIndex >= aVector.size())
+		{
+			auto element = CS::TypeHelper::makeWithAllocator<ValueType>(aVector.get_allocator());
+			auto status = aCast(element);
+			if (status == CSTypeDefines::DecodeStatus::Ok)
+			{
+				aVector.push_back(std::move(element));
+			}
+
+			return status;
+		}
+		else if constexpr (std::is_same_v<ValueType, bool>)
+		{
+			// std::vector<bool> hands out proxies instead of bool&.
+			bool element = false;
+			auto status = aCast(element);
+			aVector[aIndex] = element;
+			return status;
+		}
+		else
+		{
+			return aCast(aVector[aIndex]);
+		}
+	}
+};
+
+// @ ARRAY CONVERTER @ 
+
+// Written like a vector of the same elements, so either reads the other's
+// values. Decoding checks that there are exactly Size elements.
+template<typename ArrayType>
+struct ValueConverter<ArrayType, CS::TypeHelper::isArray<ArrayType>> : public IValueConverter
+{
+	using ValueType = typename ArrayType::value_type;
+	static constexpr std::size_t Size = std::tuple_size_v<ArrayType>;
+
+	static constexpr char tag = CSTypeDefines::csVectorTag;
+	static constexpr std::string_view signature() { return CS::TypeHelper::Signature<tag, ValueConverter<ValueType>::tag>::view(); }
+
+	const std::string& type() override { return CSTypeDefines::csVectorType; }
+
+	ArrayType cast(std::string_view aValue)
+	{
+		ArrayType casteValue{};
+		castInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	ArrayType castTyped(std::string_view aValue)
+	{
+		ArrayType casteValue{};
+		castTypedInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	void castInto(std::string_view aValue, ArrayType& aArray) { CS::Errors::throwExceptionWithStatus(tryCastInto(aValue, aArray), aValue, type()); }
+	void castTypedInto(std::string_view aValue, ArrayType& aArray) { CS::Errors::throwExceptionWithStatus(tryCastTypedInto(aValue, aArray), aValue, type()); }
+	void castUncheckedInto(std::string_view aValue, ArrayType& aArray) { CS::Errors::throwExceptionWithStatus(tryCastUncheckedInto(aValue, aArray), aValue, type()); }
+	void castCountedInto(std::string_view aValue, ArrayType& aArray) { CS::Errors::throwExceptionWithStatus(tryCastCountedInto(aValue, aArray), aValue, type()); }
+
+	// Non-throwing casts, the ones above throw what these return.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, ArrayType& aArray)
+	{
+		std::size_t valuesAmount = 0;
+
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			auto status = PackedNumbers<ValueType>::tryCastString(aValue, valuesAmount, [&aArray](std::size_t aIndex, ValueType aNumber)
+			{
+				if (aIndex < Size)
+				{
+					aArray[aIndex] = aNumber;
+				}
+			});
+
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+		}
+		else if (Size != 0)
+		{
+			// An empty value is one empty element, there are no empty arrays to mistake it for.
+			ValueConverter<ValueType> valueConverter;
+			for (auto value : CS::DataHelper::split(aValue, CSTypeDefines::csContainerValuesDelimiter))
+			{
+				if (valuesAmount < Size)
+				{
+					auto status = valueConverter.tryCastInto(value, aArray[valuesAmount]);
+					if (status != CSTypeDefines::DecodeStatus::Ok)
+					{
+						return status;
+					}
+				}
+
+				++valuesAmount;
+			}
+		}
+		else if (!aValue.empty())
+		{
+			valuesAmount = 1;
+		}
+
+		return valuesAmount == Size ? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::FailedToParse;
+	}
+
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, ArrayType& aArray)
+	{
+		if (!CS::TypeHelper::hasSignature(aValue, signature()))
+		{
+			// Not our header: there is no empty array to clear to, any other container mismatches.
+			std::string_view valueType;
+			std::string_view innerTypes;
+			if (!CS::DataHelper::splitContainerHeader(aValue, valueType, innerTypes))
+			{
+				return CSTypeDefines::DecodeStatus::FailedToParse;
+			}
+
+			return CSTypeDefines::DecodeStatus::TypeMismatch;
+		}
+
+		return tryCastCountedInto(aValue.substr(signature().size()), aArray);
+	}
+
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, ArrayType& aArray) { return tryCastCountedInto(CS::TypeHelper::skipSignature(aValue, signature()), aArray); }
+
+	// The typed text without its header, "count$values".
+	CSTypeDefines::DecodeStatus tryCastCountedInto(std::string_view aValue, ArrayType& aArray)
+	{
+		CS::DataHelper::ContainerParts parts;
+		if (!CS::DataHelper::trySplitCounted(aValue, signature(), parts) || (parts.hasCount && parts.count != Size))
+		{
+			return CSTypeDefines::DecodeStatus::FailedToParse;
+		}
+
+		return tryCastInto(parts.values, aArray);
+	}
+
+	std::string toString(const ArrayType& aValue)
+	{
+		std::string string;
+		string.reserve(stringSize(aValue));
+		appendString(string, aValue);
+		return string;
+	}
+
+	std::string toTyped(const ArrayType& aValue)
+	{
+		std::string string;
+		string.reserve(typedSize(aValue));
+		appendTyped(string, aValue);
+		return string;
+	}
+
+	void appendString(std::string& aBuffer, const ArrayType& aValue)
+	{
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			PackedNumbers<ValueType>::appendString(aBuffer, aValue.data(), Size);
+			return;
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		for (std::size_t index = 0; index < Size; ++index)
+		{
+			if (index != 0)
+			{
+				aBuffer += CSTypeDefines::csContainerValuesDelimiter;
+			}
+
+			valueConverter.appendString(aBuffer, aValue[index]);
+		}
+	}
+
+	std::size_t stringSize(const ArrayType& aValue)
+	{
+		std::size_t size = 0;
+		if constexpr (Size != 0)
+		{
+			ValueConverter<ValueType> valueConverter;
+			for (auto& value : aValue)
+			{
+				size += valueConverter.stringSize(value);
+			}
+
+			size += (Size - 1) * CSTypeDefines::csContainerValuesDelimiter.size();
+		}
+
+		return size;
+	}
+
+	void appendTyped(std::string& aBuffer, const ArrayType& aValue)
+	{
+		aBuffer += signature();
+		CS::TypeHelper::appendContainerCount(aBuffer, Size);
+		appendString(aBuffer, aValue);
+	}
+
+	std::size_t typedSize(const ArrayType& aValue) { return signature().size() + CS::TypeHelper::containerCountSize(Size) + stringSize(aValue); }
+
+	void appendBinary(std::string& aBuffer, const ArrayType& aValue)
+	{
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			PackedNumbers<ValueType>::appendBinary(aBuffer, aValue.data(), Size);
+			return;
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		CS::BinaryHelper::appendVarint(aBuffer, Size);
+		for (auto& value : aValue)
+		{
+			valueConverter.appendBinary(aBuffer, value);
+		}
+	}
+
+	std::size_t binarySize(const ArrayType& aValue)
+	{
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			return PackedNumbers<ValueType>::binarySize(Size);
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		std::size_t size = CS::BinaryHelper::varintSize(Size);
+		for (auto& value : aValue)
+		{
+			size += valueConverter.binarySize(value);
+		}
+
+		return size;
+	}
+
+	ArrayType castBinary(std::string_view& aValue)
+	{
+		ArrayType casteValue{};
+		castBinaryInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	void castBinaryInto(std::string_view& aValue, ArrayType& aArray) { CS::Errors::throwExceptionWithStatus(tryCastBinaryInto(aValue, aArray), {}, type()); }
+
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, ArrayType& aArray)
+	{
+		std::uint64_t valuesAmount = 0;
+		if (!CS::BinaryHelper::tryReadVarint(aValue, valuesAmount) || valuesAmount != Size)
+		{
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			return CS::BinaryHelper::tryReadRawBlock(aValue, aArray.data(), Size) ? CSTypeDefines::DecodeStatus::Ok : CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		for (auto& value : aArray)
+		{
+			auto status = valueConverter.tryCastBinaryInto(aValue, value);
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+		}
+
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+	void skipBinary(std::string_view& aValue)
+	{
+		if (CS::BinaryHelper::readVarint(aValue) != Size)
+		{
+			CS::Errors::throwExceptionMalformedBinary(CS::TypeHelper::tryGetFullType(type()));
+		}
+
+		if constexpr (CS::TypeHelper::IsPackedNumber<ValueType>::value)
+		{
+			CS::BinaryHelper::readBytes(aValue, Size * sizeof(ValueType));
+			return;
+		}
+
+		ValueConverter<ValueType> valueConverter;
+		for (std::size_t index = 0; index < Size; ++index)
+		{
+			valueConverter.skipBinary(aValue);
+		}
+	}
+};
+
+// @ PAIR CONVERTER @ 
+
+template<typename PairType>
+struct ValueConverter<PairType, CS::TypeHelper::isPair<PairType>> : public IValueConverter
+{
+	using FirstType = typename PairType::first_type;
+	using SecondType = typename PairType::second_type;
+
+	static constexpr char tag = CSTypeDefines::csPairTag;
+	static constexpr std::string_view signature()
+	{
+		return CS::TypeHelper::Signature<tag, ValueConverter<FirstType>::tag, ValueConverter<SecondType>::tag>::view();
+	}
+
+	virtual const std::string& type() override { return CSTypeDefines::csPairType; };
+
+	PairType cast(std::string_view aValue)
+	{
+		const auto [firstValue, secondValue] = CS::DataHelper::splitTwoValues(aValue, CSTypeDefines::csContainerValuesDelimiter);
+
+		ValueConverter<FirstType> firstValueConverter;
+		ValueConverter<SecondType> secondValueConverter;
+
+		return { firstValueConverter.cast(firstValue), secondValueConverter.cast(secondValue) };
+	}
+
+	PairType castTyped(std::string_view aValue)
+	{
+		PairType casteValue{};
+		castTypedInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	void castInto(std::string_view aValue, PairType& aPair) { CS::Errors::throwExceptionWithStatus(tryCastInto(aValue, aPair), aValue, type()); }
+	void castTypedInto(std::string_view aValue, PairType& aPair) { CS::Errors::throwExceptionWithStatus(tryCastTypedInto(aValue, aPair), aValue, type()); }
+	void castUncheckedInto(std::string_view aValue, PairType& aPair) { CS::Errors::throwExceptionWithStatus(tryCastUncheckedInto(aValue, aPair), aValue, type()); }
+
+	// Non-throwing casts, the ones above throw what these return.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, PairType& aPair)
+	{
+		const auto [firstValue, secondValue] = CS::DataHelper::splitTwoValues(aValue, CSTypeDefines::csContainerValuesDelimiter);
+
+		ValueConverter<FirstType> firstValueConverter;
+		ValueConverter<SecondType> secondValueConverter;
+
+		auto status = firstValueConverter.tryCastInto(firstValue, aPair.first);
+		return status == CSTypeDefines::DecodeStatus::Ok ? secondValueConverter.tryCastInto(secondValue, aPair.second) : status;
+	}
+
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, PairType& aPair)
+	{
+		if (CS::TypeHelper::hasSignature(aValue, signature()))
+		{
+			return tryCastUncheckedInto(aValue, aPair);
+		}
+
+		// Not our header: a value that is not a typed pair clears, any other type mismatches.
+		std::array<std::string_view, 3> splitedPairData;
+		if (!CS::DataHelper::splitValues(aValue, CSTypeDefines::csTypeDelimiter, splitedPairData) 
+			|| splitedPairData[0].empty() || splitedPairData[1].empty() || splitedPairData[2].empty())
+		{
+			aPair = PairType{};
+			return CSTypeDefines::DecodeStatus::Ok;
+		}
+
+		return CSTypeDefines::DecodeStatus::TypeMismatch;
+	}
+
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, PairType& aPair)
+	{
+		auto pairValue = CS::TypeHelper::skipSignature(aValue, signature());
+		if (pairValue.empty())
+		{
+			aPair = PairType{};
+			return CSTypeDefines::DecodeStatus::Ok;
+		}
+
+		return tryCastInto(pairValue, aPair);
 	}
 
 	std::string toString(const PairType& aValue)
 	{
-		std::string string;
+		std::string string;
+		string.reserve(stringSize(aValue));
+		appendString(string, aValue);
+		return string;
+	}
+
+	std::string toTyped(const PairType& aValue)
+	{
+		std::string typedString;
+		typedString.reserve(typedSize(aValue));
+		appendTyped(typedString, aValue);
+		return typedString;
+	}
+
+	void appendString(std::string& aBuffer, const PairType& aValue)
+	{
+		ValueConverter<FirstType> firstValueConverter;
+		ValueConverter<SecondType> secondValueConverter;
+
+		firstValueConverter.appendString(aBuffer, aValue.first);
+		aBuffer += CSTypeDefines::csContainerValuesDelimiter;
+		secondValueConverter.appendString(aBuffer, aValue.second);
+	}
+
+	std::size_t stringSize(const PairType& aValue)
+	{
+		ValueConverter<FirstType> firstValueConverter;
+		ValueConverter<SecondType> secondValueConverter;
+
+		return firstValueConverter.stringSize(aValue.first) 
+			+ CSTypeDefines::csContainerValuesDelimiter.size() 
+			+ secondValueConverter.stringSize(aValue.second);
+	}
+
+	void appendTyped(std::string& aBuffer, const PairType& aValue)
+	{
+		aBuffer += signature();
+		appendString(aBuffer, aValue);
+	}
+
+	std::size_t typedSize(const PairType& aValue) { return signature().size() + stringSize(aValue); }
+
+	void appendBinary(std::string& aBuffer, const PairType& aValue)
+	{
+		ValueConverter<FirstType> firstValueConverter;
+		ValueConverter<SecondType> secondValueConverter;
+
+		firstValueConverter.appendBinary(aBuffer, aValue.first);
+		secondValueConverter.appendBinary(aBuffer, aValue.second);
+	}
 
+	std::size_t binarySize(const PairType& aValue)
+	{
 		ValueConverter<FirstType> firstValueConverter;
 		ValueConverter<SecondType> secondValueConverter;
 
-		string += firstValueConverter.toString(std::get<FirstType>(aValue));
-		string += secondValueConverter.toString(std::get<SecondType>(aValue));
+		return firstValueConverter.binarySize(aValue.first) + secondValueConverter.binarySize(aValue.second);
+	}
 
-		return string;
+	PairType castBinary(std::string_view& aValue)
+	{
+		ValueConverter<FirstType> firstValueConverter;
+		ValueConverter<SecondType> secondValueConverter;
+
+		auto first = firstValueConverter.castBinary(aValue);
+		return { std::move(first), secondValueConverter.castBinary(aValue) };
 	}
 
-	std::string toTyped(const PairType& aValue)
+	void castBinaryInto(std::string_view& aValue, PairType& aPair) { CS::Errors::throwExceptionWithStatus(tryCastBinaryInto(aValue, aPair), {}, type()); }
+
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, PairType& aPair)
 	{
 		ValueConverter<FirstType> firstValueConverter;
 		ValueConverter<SecondType> secondValueConverter;
 
-		auto formatedType = CS::TypeHelper::formatContainerTypes(type(), 
-			{ firstValueConverter.type(), secondValueConverter.type() });
+		auto status = firstValueConverter.tryCastBinaryInto(aValue, aPair.first);
+		return status == CSTypeDefines::DecodeStatus::Ok ? secondValueConverter.tryCastBinaryInto(aValue, aPair.second) : status;
+	}
 
-		std::string typedString;
-		typedString += std::move(formatedType);
-		typedString += toString(aValue);
+	void skipBinary(std::string_view& aValue)
+	{
+		ValueConverter<FirstType> firstValueConverter;
+		ValueConverter<SecondType> secondValueConverter;
 
-		return typedString;
+		firstValueConverter.skipBinary(aValue);
+		secondValueConverter.skipBinary(aValue);
 	}
 };
 
-// @ PAIR CONVERTER @ 
+// @ MAP CONVERTER @ 
+
+template<typename MapType>
+struct ValueConverter<MapType, CS::TypeHelper::isMap<MapType>> : public IValueConverter
+{
+	using KeyType = typename MapType::key_type;
+	using ValueType = typename MapType::mapped_type;
+
+	static constexpr char tag = CSTypeDefines::csMapTag;
+	static constexpr std::string_view signature()
+	{
+		return CS::TypeHelper::Signature<tag, ValueConverter<KeyType>::tag, ValueConverter<ValueType>::tag>::view();
+	}
+
+	const std::string& type() override { return CSTypeDefines::csMapType; }
+
+	MapType cast(std::string_view aValue)
+	{
+		MapType casteValue{};
+		castInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	MapType castTyped(std::string_view aValue)
+	{
+		MapType casteValue{};
+		castTypedInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	// Replaces the entries of aMap with the "key^value#key^value" ones. The old
+	// nodes are reused for the decoded entries, see RecycledNodes.
+	void castInto(std::string_view aValue, MapType& aMap) { CS::Errors::throwExceptionWithStatus(tryCastInto(aValue, aMap), aValue, type()); }
+
+	void castTypedInto(std::string_view aValue, MapType& aMap, const StructuralIndex* aIndex = nullptr)
+	{
+		CS::Errors::throwExceptionWithStatus(tryCastTypedInto(aValue, aMap, aIndex), aValue, type());
+	}
+
+	void castUncheckedInto(std::string_view aValue, MapType& aMap, const StructuralIndex* aIndex = nullptr)
+	{
+		CS::Errors::throwExceptionWithStatus(tryCastUncheckedInto(aValue, aMap, aIndex), aValue, type());
+	}
+
+	void castCountedInto(std::string_view aValue, MapType& aMap, const StructuralIndex* aIndex = nullptr)
+	{
+		CS::Errors::throwExceptionWithStatus(tryCastCountedInto(aValue, aMap, aIndex), aValue, type());
+	}
+
+	// Non-throwing casts, the ones above throw what these return.
+	CSTypeDefines::DecodeStatus tryCastInto(std::string_view aValue, MapType& aMap)
+	{
+		std::size_t entriesAmount = 0;
+		RecycledNodes nodes(aMap);
+		return castEntries(aValue, nodes, entriesAmount);
+	}
+
+	// A counted value pre-sizes hashed maps before the entries go in. With
+	// aIndex the entries are cut from its positions, see the vector one.
+	CSTypeDefines::DecodeStatus tryCastTypedInto(std::string_view aValue, MapType& aMap, const StructuralIndex* aIndex = nullptr)
+	{
+		if (!CS::TypeHelper::hasSignature(aValue, signature()))
+		{
+			// Not our header: a value that is not a container clears, any other type mismatches.
+			std::string_view valueType;
+			std::string_view innerTypes;
+			if (!CS::DataHelper::splitContainerHeader(aValue, valueType, innerTypes) || valueType.empty() || innerTypes.empty())
+			{
+				aMap.clear();
+				return CSTypeDefines::DecodeStatus::Ok;
+			}
+
+			return CSTypeDefines::DecodeStatus::TypeMismatch;
+		}
+
+		return tryCastCountedInto(aValue.substr(signature().size()), aMap, aIndex);
+	}
+
+	CSTypeDefines::DecodeStatus tryCastUncheckedInto(std::string_view aValue, MapType& aMap, const StructuralIndex* aIndex = nullptr)
+	{
+		return tryCastCountedInto(CS::TypeHelper::skipSignature(aValue, signature()), aMap, aIndex);
+	}
+
+	// The typed text without its header, "count$values".
+	CSTypeDefines::DecodeStatus tryCastCountedInto(std::string_view aValue, MapType& aMap, const StructuralIndex* aIndex = nullptr)
+	{
+		CS::DataHelper::ContainerParts parts;
+		if (!CS::DataHelper::trySplitCounted(aValue, signature(), parts))
+		{
+			return CSTypeDefines::DecodeStatus::FailedToParse;
+		}
+
+		return castParts(parts, aMap, aIndex);
+	}
+
+	// Same split as the vector one. The nodes of aMap are parked in aSpare,
+	// which LineSaveParser keeps across its chunks, and reused by the entries
+	// as they arrive; the ones left over are freed by endElements.
+	void beginElements(std::size_t aCount, bool aHasCount, MapType& aMap, std::shared_ptr<void>& aSpare)
+	{
+		if (aHasCount)
+		{
+			CS::Limits::checkCount(aCount, CS::Limits::maxMapEntries, type());
+		}
+
+		if (!aSpare)
+		{
+			aSpare = std::make_shared<typename RecycledNodes::Nodes>();
+		}
+
+		RecycledNodes::take(aMap, spareNodesOf(aSpare));
+	}
+
+	void castElementInto(std::string_view aEntry, std::size_t aIndex, MapType& aMap, std::shared_ptr<void>& aSpare)
+	{
+		CS::Limits::checkCount(aIndex + 1, CS::Limits::maxMapEntries, type());
+
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		const auto [key, value] = CS::DataHelper::splitTwoValues(aEntry, CSTypeDefines::csContainerValuesDelimiter);
+		RecycledNodes nodes(aMap, spareNodesOf(aSpare));
+		auto status = nodes.insert([&keyConverter, key = key](KeyType& aKey) { return keyConverter.tryCastInto(key, aKey); },
+			[&valueConverter, value = value](ValueType& aMapped) { return valueConverter.tryCastInto(value, aMapped); });
+		CS::Errors::throwExceptionWithStatus(status, aEntry, type());
+	}
+
+	void endElements(std::size_t aAmount, std::size_t aCount, bool aHasCount, std::shared_ptr<void>& aSpare)
+	{
+		if (aSpare)
+		{
+			spareNodesOf(aSpare).clear();
+		}
+
+		if (aHasCount && aAmount != aCount)
+		{
+			CS::Errors::throwExceptionFailedToParse(std::to_string(aCount), type());
+		}
+	}
+
+	std::string toString(const MapType& aValue)
+	{
+		std::string string;
+		string.reserve(stringSize(aValue));
+		appendString(string, aValue);
+		return string;
+	}
+
+	std::string toTyped(const MapType& aValue)
+	{
+		std::string string;
+		string.reserve(typedSize(aValue));
+		appendTyped(string, aValue);
+		return string;
+	}
+
+	void appendString(std::string& aBuffer, const MapType& aValue)
+	{
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		auto valuesAmount = aValue.size();
+		for (auto& [key, value] : aValue)
+		{
+			keyConverter.appendString(aBuffer, key);
+			aBuffer += CSTypeDefines::csContainerValuesDelimiter;
+			valueConverter.appendString(aBuffer, value);
+			if (--valuesAmount != 0)
+			{
+				aBuffer += CSTypeDefines::csMapValueDelimiter;
+			}
+		}
+	}
+
+	std::size_t stringSize(const MapType& aValue)
+	{
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		std::size_t size = 0;
+		for (auto& [key, value] : aValue)
+		{
+			size += keyConverter.stringSize(key) + CSTypeDefines::csContainerValuesDelimiter.size() + valueConverter.stringSize(value);
+		}
+
+		if (!aValue.empty())
+		{
+			size += (aValue.size() - 1) * CSTypeDefines::csMapValueDelimiter.size();
+		}
+
+		return size;
+	}
+
+	void appendTyped(std::string& aBuffer, const MapType& aValue)
+	{
+		aBuffer += signature();
+		CS::TypeHelper::appendContainerCount(aBuffer, aValue.size());
+		appendString(aBuffer, aValue);
+	}
+
+	std::size_t typedSize(const MapType& aValue) { return signature().size() + CS::TypeHelper::containerCountSize(aValue.size()) + stringSize(aValue); }
+
+	// Entry count, then key and value of every entry.
+	void appendBinary(std::string& aBuffer, const MapType& aValue)
+	{
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		CS::BinaryHelper::appendVarint(aBuffer, aValue.size());
+		for (auto& [key, value] : aValue)
+		{
+			keyConverter.appendBinary(aBuffer, key);
+			valueConverter.appendBinary(aBuffer, value);
+		}
+	}
+
+	std::size_t binarySize(const MapType& aValue)
+	{
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		std::size_t size = CS::BinaryHelper::varintSize(aValue.size());
+		for (auto& [key, value] : aValue)
+		{
+			size += keyConverter.binarySize(key) + valueConverter.binarySize(value);
+		}
+
+		return size;
+	}
+
+	MapType castBinary(std::string_view& aValue)
+	{
+		MapType casteValue{};
+		castBinaryInto(aValue, casteValue);
+		return casteValue;
+	}
+
+	void castBinaryInto(std::string_view& aValue, MapType& aMap) { CS::Errors::throwExceptionWithStatus(tryCastBinaryInto(aValue, aMap), {}, type()); }
+
+	CSTypeDefines::DecodeStatus tryCastBinaryInto(std::string_view& aValue, MapType& aMap)
+	{
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		std::uint64_t valuesAmount = 0;
+		if (!CS::BinaryHelper::tryReadVarint(aValue, valuesAmount))
+		{
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+		else if (valuesAmount > CS::Limits::maxMapEntries)
+		{
+			return CSTypeDefines::DecodeStatus::CountOverLimit;
+		}
+		else if (valuesAmount > aValue.size())
+		{
+			return CSTypeDefines::DecodeStatus::MalformedBinary;
+		}
+
+		RecycledNodes nodes(aMap);
+		reserveEntries(aMap, static_cast<std::size_t>(valuesAmount));
+		for (std::uint64_t index = 0; index < valuesAmount; ++index)
+		{
+			auto status = nodes.insert([&keyConverter, &aValue](KeyType& aKey) { return keyConverter.tryCastBinaryInto(aValue, aKey); },
+				[&valueConverter, &aValue](ValueType& aMapped) { return valueConverter.tryCastBinaryInto(aValue, aMapped); });
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+		}
+
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+	void skipBinary(std::string_view& aValue)
+	{
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		auto valuesAmount = CS::BinaryHelper::readVarint(aValue);
+		if (valuesAmount > aValue.size())
+		{
+			CS::Errors::throwExceptionMalformedBinary(CS::TypeHelper::tryGetFullType(type()));
+		}
+
+		for (std::uint64_t index = 0; index < valuesAmount; ++index)
+		{
+			keyConverter.skipBinary(aValue);
+			valueConverter.skipBinary(aValue);
+		}
+	}
+
+	// Takes the nodes out of a map that is decoded into, so every decoded
+	// entry is written over an old node and its key and value keep their
+	// capacity. Nodes left over are freed when decoding ends or throws. The
+	// node list is kept per thread, so a steady stream of maps of the same
+	// size decodes without allocating.
+	struct RecycledNodes
+	{
+	public:
+		using Nodes = std::vector<typename MapType::node_type>;
+
+		explicit RecycledNodes(MapType& aMap) : map{ aMap }, nodes{ spareNodes() }, ownsNodes{ true }
+		{
+			take(map, nodes);
+		}
+
+		// Inserts from aNodes, a list the caller fills with take() and frees itself.
+		RecycledNodes(MapType& aMap, Nodes& aNodes) : map{ aMap }, nodes{ aNodes } {}
+
+		RecycledNodes(const RecycledNodes&) = delete;
+		RecycledNodes& operator=(const RecycledNodes&) = delete;
+
+		~RecycledNodes()
+		{
+			if (ownsNodes)
+			{
+				nodes.clear();
+			}
+		}
+
+		// Moves the nodes of aMap to the back of aNodes.
+		static void take(MapType& aMap, Nodes& aNodes)
+		{
+			auto nodesAmount = aNodes.size();
+			while (!aMap.empty())
+			{
+				aNodes.push_back(aMap.extract(aMap.begin()));
+			}
+
+			// Reused from the back: entries encoded in map order land in the node that held them.
+			std::reverse(aNodes.begin() + static_cast<std::ptrdiff_t>(nodesAmount), aNodes.end());
+		}
+
+		// aCastKey and aCastValue decode the next entry into the references
+		// given to them and return its status. A failed entry is not inserted,
+		// unless only its value failed and the key is new to the map.
+		template<typename CastKey, typename CastValue>
+		CSTypeDefines::DecodeStatus insert(CastKey&& aCastKey, CastValue&& aCastValue)
+		{
+			if (nodes.empty())
+			{
+				auto key = CS::TypeHelper::makeWithAllocator<KeyType>(map.get_allocator());
+				auto status = aCastKey(key);
+				return status == CSTypeDefines::DecodeStatus::Ok ? aCastValue(map.try_emplace(std::move(key)).first->second) : status;
+			}
+
+			auto& node = nodes.back();
+			auto status = aCastKey(node.key());
+			if (status == CSTypeDefines::DecodeStatus::Ok)
+			{
+				status = aCastValue(node.mapped());
+			}
+
+			if (status != CSTypeDefines::DecodeStatus::Ok)
+			{
+				return status;
+			}
+
+			// A repeated key keeps the last value and leaves the node for the next entry.
+			auto position = map.insert(map.end(), std::move(node));
+			if (node)
+			{
+				position->second = std::move(node.mapped());
+			}
+			else
+			{
+				nodes.pop_back();
+			}
+
+			return CSTypeDefines::DecodeStatus::Ok;
+		}
+
+	private:
+		MapType& map;
+		Nodes& nodes;
+		bool ownsNodes = false;
+
+		static Nodes& spareNodes()
+		{
+			thread_local Nodes nodes;
+			return nodes;
+		}
+	};
+
+private:
+	static typename RecycledNodes::Nodes& spareNodesOf(const std::shared_ptr<void>& aSpare) { return *static_cast<typename RecycledNodes::Nodes*>(aSpare.get()); }
+
+	CSTypeDefines::DecodeStatus castParts(const CS::DataHelper::ContainerParts& aParts, MapType& aMap, const StructuralIndex* aIndex)
+	{
+		std::size_t entriesAmount = 0;
+		if (!aParts.hasCount)
+		{
+			RecycledNodes nodes(aMap);
+			return castEntries(aParts.values, nodes, entriesAmount, aIndex);
+		}
+		else if (aParts.count > CS::Limits::maxMapEntries)
+		{
+			return CSTypeDefines::DecodeStatus::CountOverLimit;
+		}
+
+		RecycledNodes nodes(aMap);
+		reserveEntries(aMap, aParts.count);
+		auto status = castEntries(aParts.values, nodes, entriesAmount, aIndex);
+		if (status == CSTypeDefines::DecodeStatus::Ok && entriesAmount != aParts.count)
+		{
+			return CSTypeDefines::DecodeStatus::FailedToParse;
+		}
+
+		return status;
+	}
+
+	// aEntriesAmount is set to the amount of entries read, repeated keys included.
+	CSTypeDefines::DecodeStatus castEntries(std::string_view aValue, RecycledNodes& aNodes, std::size_t& aEntriesAmount, const StructuralIndex* aIndex = nullptr)
+	{
+		aEntriesAmount = 0;
+		if (aValue.empty())
+		{
+			return CSTypeDefines::DecodeStatus::Ok;
+		}
+
+		ValueConverter<KeyType> keyConverter;
+		ValueConverter<ValueType> valueConverter;
+
+		auto castEntry = [&aNodes, &aEntriesAmount, &keyConverter, &valueConverter](std::string_view aKeyValue)
+		{
+			const auto [key, value] = CS::DataHelper::splitTwoValues(aKeyValue, CSTypeDefines::csContainerValuesDelimiter);
+			++aEntriesAmount;
+			return aNodes.insert([&keyConverter, key = key](KeyType& aKey) { return keyConverter.tryCastInto(key, aKey); },
+				[&valueConverter, value = value](ValueType& aMapped) { return valueConverter.tryCastInto(value, aMapped); });
+		};
+
+		if (aIndex)
+		{
+			for (auto keyValue : aIndex->split(aValue, CSTypeDefines::csMapValueDelimiter))
+			{
+				auto status = castEntry(keyValue);
+				if (status != CSTypeDefines::DecodeStatus::Ok)
+				{
+					return status;
+				}
+			}
+		}
+		else
+		{
+			for (auto keyValue : CS::DataHelper::split(aValue, CSTypeDefines::csMapValueDelimiter))
+			{
+				auto status = castEntry(keyValue);
+				if (status != CSTypeDefines::DecodeStatus::Ok)
+				{
+					return status;
+				}
+			}
+		}
+
+		return CSTypeDefines::DecodeStatus::Ok;
+	}
+
+	static void reserveEntries(MapType& aMap, std::size_t aEntriesAmount)
+	{
+		if constexpr (CS::TypeHelper::HasReserve<MapType>::value)
+		{
+			aMap.reserve(aEntriesAmount);
+		}
+	}
+};
+
+// @ MAP CONVERTER @ 
 
 #endif // !__CS_VALUE_CONVERTER_H__
\ No newline at end of file
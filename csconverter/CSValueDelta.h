@@ -0,0 +1,369 @@
+#ifndef __CS_VALUE_DELTA_H__
+#define __CS_VALUE_DELTA_H__
+
+#include "CSValueConverter.h"
+#include "CSFramedValue.h"
+
+#include <algorithm>
+
+// A delta lists only the fields that differ from a previous version of the
+// object. Every entry is the field position in key order, a DeltaOperation
+// character and the payload:
+//
+//	text:   3=s$cat|0+m$s^i$1$test10^800|1-v$s$1$test2
+//	framed: 3=s$3:cat|0+m$s^i$13:6:test103:800|1-v$s$7:5:test2
+//	binary: varint position, operation byte, binary payload
+//
+// Payloads use the regular value encodings of the format.
+
+struct DeltaWriter
+{
+public:
+	DeltaWriter(std::string& aBuffer, CSTypeDefines::WireFormat aFormat)
+		: buffer{ aBuffer }, format{ aFormat } {}
+
+	void setField(std::size_t aFieldIndex) { fieldIndex = aFieldIndex; }
+
+	// Starts an entry for the current field, its payload is appended next.
+	void beginEntry(CSTypeDefines::DeltaOperation aOperation)
+	{
+		if (format == CSTypeDefines::WireFormat::Binary)
+		{
+			CS::BinaryHelper::appendVarint(buffer, fieldIndex);
+			buffer += static_cast<char>(aOperation);
+			return;
+		}
+
+		if (entriesAmount != 0)
+		{
+			buffer += CSTypeDefines::csValueDelimiter;
+		}
+
+		ValueConverter<std::size_t> indexConverter;
+		indexConverter.appendString(buffer, fieldIndex);
+		buffer += static_cast<char>(aOperation);
+		++entriesAmount;
+	}
+
+	template<typename Type>
+	void appendValue(const Type& aValue)
+	{
+		ValueConverter<Type> converter;
+		if (format == CSTypeDefines::WireFormat::Binary)
+		{
+			converter.appendBinary(buffer, aValue);
+		}
+		else if (format == CSTypeDefines::WireFormat::Framed)
+		{
+			FramedField::append(buffer, aValue);
+		}
+		else
+		{
+			converter.appendTyped(buffer, aValue);
+		}
+	}
+
+private:
+	std::string& buffer;
+	CSTypeDefines::WireFormat format;
+	std::size_t fieldIndex = 0;
+	std::size_t entriesAmount = 0;
+};
+
+struct DeltaReader
+{
+public:
+	DeltaReader(std::string_view aDelta, CSTypeDefines::WireFormat aFormat)
+		: data{ aDelta }, format{ aFormat } {}
+
+	// Reads the header of the next entry. Returns false at the end of the delta.
+	bool nextEntry(std::size_t& aFieldIndex, CSTypeDefines::DeltaOperation& aOperation)
+	{
+		if (data.empty())
+		{
+			return false;
+		}
+
+		char operation = 0;
+		if (format == CSTypeDefines::WireFormat::Binary)
+		{
+			aFieldIndex = static_cast<std::size_t>(CS::BinaryHelper::readVarint(data));
+			operation = CS::BinaryHelper::readBytes(data, 1)[0];
+		}
+		else
+		{
+			// Text entries are cut at the next "|". Framed payloads may hold "|",
+			// they are read straight from data and the "|" comes after them.
+			auto& header = format == CSTypeDefines::WireFormat::Framed ? data : payload;
+			if (format == CSTypeDefines::WireFormat::Framed)
+			{
+				if (entriesAmount != 0)
+				{
+					CS::FramingHelper::readValueDelimiter(data);
+				}
+			}
+			else
+			{
+				auto entryEnd = data.find(CSTypeDefines::csValueDelimiter);
+				payload = data.substr(0, entryEnd);
+				data.remove_prefix(entryEnd == std::string_view::npos ? data.size() : entryEnd + CSTypeDefines::csValueDelimiter.size());
+			}
+
+			auto [indexEnd, error] = std::from_chars(header.data(), header.data() + header.size(), aFieldIndex);
+			if (error != std::errc{} || indexEnd == header.data() + header.size())
+			{
+				CS::Errors::throwExceptionMalformedDelta("entry header");
+			}
+
+			operation = *indexEnd;
+			header.remove_prefix(static_cast<std::size_t>(indexEnd - header.data()) + 1);
+			++entriesAmount;
+		}
+
+		if (operation != static_cast<char>(CSTypeDefines::DeltaOperation::Replace)
+			&& operation != static_cast<char>(CSTypeDefines::DeltaOperation::Insert)
+			&& operation != static_cast<char>(CSTypeDefines::DeltaOperation::Remove))
+		{
+			CS::Errors::throwExceptionMalformedDelta("entry operation");
+		}
+
+		aOperation = static_cast<CSTypeDefines::DeltaOperation>(operation);
+		return true;
+	}
+
+	// Reads the payload of the current entry.
+	template<typename Type>
+	Type readValue()
+	{
+		Type value{};
+		readValueInto(value);
+
+		return value;
+	}
+
+	// Same, decoded through aValue so its allocator is kept.
+	template<typename Type>
+	void readValueInto(Type& aValue)
+	{
+		ValueConverter<Type> converter;
+		if (format == CSTypeDefines::WireFormat::Binary)
+		{
+			converter.castBinaryInto(data, aValue);
+			return;
+		}
+
+		if (format == CSTypeDefines::WireFormat::Framed)
+		{
+			FramedField::castInto(data, aValue);
+			return;
+		}
+
+		converter.castTypedInto(payload, aValue);
+		payload = {};
+	}
+
+private:
+	std::string_view data;
+	std::string_view payload;
+	CSTypeDefines::WireFormat format;
+	std::size_t entriesAmount = 0;
+};
+
+// Scalars, strings and pairs are either unchanged or replaced.
+template<typename Type, typename TypeDefinition = void>
+struct ValueDelta
+{
+	static void append(DeltaWriter& aWriter, const Type& aValue, const Type& aPrevious)
+	{
+		if (!(aValue == aPrevious))
+		{
+			aWriter.beginEntry(CSTypeDefines::DeltaOperation::Replace);
+			aWriter.appendValue(aValue);
+		}
+	}
+
+	static void apply(DeltaReader& aReader, CSTypeDefines::DeltaOperation aOperation, Type& aValue)
+	{
+		if (aOperation != CSTypeDefines::DeltaOperation::Replace)
+		{
+			CS::Errors::throwExceptionMalformedDelta("operation on a value that is not a container");
+		}
+
+		aReader.readValueInto(aValue);
+	}
+};
+
+// @ VECTOR DELTA @
+
+// Appended elements or a truncation when the old and new vectors share a
+// prefix, otherwise the whole vector.
+template<typename VectorType>
+struct ValueDelta<VectorType, CS::TypeHelper::isVector<VectorType>>
+{
+	static void append(DeltaWriter& aWriter, const VectorType& aValue, const VectorType& aPrevious)
+	{
+		if (aValue == aPrevious)
+		{
+			return;
+		}
+
+		auto commonSize = std::min(aValue.size(), aPrevious.size());
+		if (!std::equal(aValue.begin(), aValue.begin() + commonSize, aPrevious.begin()))
+		{
+			aWriter.beginEntry(CSTypeDefines::DeltaOperation::Replace);
+			aWriter.appendValue(aValue);
+		}
+		else if (aValue.size() > commonSize)
+		{
+			aWriter.beginEntry(CSTypeDefines::DeltaOperation::Insert);
+			aWriter.appendValue(VectorType(aValue.begin() + commonSize, aValue.end()));
+		}
+		else
+		{
+			aWriter.beginEntry(CSTypeDefines::DeltaOperation::Remove);
+			aWriter.appendValue(static_cast<std::uint64_t>(aValue.size()));
+		}
+	}
+
+	static void apply(DeltaReader& aReader, CSTypeDefines::DeltaOperation aOperation, VectorType& aValue)
+	{
+		if (aOperation == CSTypeDefines::DeltaOperation::Insert)
+		{
+			VectorType appended(aValue.get_allocator());
+			aReader.readValueInto(appended);
+			aValue.insert(aValue.end(), std::make_move_iterator(appended.begin()), std::make_move_iterator(appended.end()));
+		}
+		else if (aOperation == CSTypeDefines::DeltaOperation::Remove)
+		{
+			auto size = aReader.readValue<std::uint64_t>();
+			if (size > aValue.size())
+			{
+				CS::Errors::throwExceptionMalformedDelta("vector size");
+			}
+
+			aValue.erase(aValue.begin() + static_cast<std::ptrdiff_t>(size), aValue.end());
+		}
+		else
+		{
+			aReader.readValueInto(aValue);
+		}
+	}
+};
+
+// @ MAP DELTA @
+
+// Erased keys plus added or changed entries. The whole map is sent instead
+// when no entry stayed unchanged.
+template<typename MapType>
+struct ValueDelta<MapType, CS::TypeHelper::isMap<MapType>>
+{
+	using KeyType = typename MapType::key_type;
+
+	static void append(DeltaWriter& aWriter, const MapType& aValue, const MapType& aPrevious)
+	{
+		std::vector<KeyType> erasedKeys;
+		MapType changedEntries;
+
+		if constexpr (std::is_same_v<MapType, std::map<KeyType, typename MapType::mapped_type, std::less<KeyType>, typename MapType::allocator_type>>)
+		{
+			// Both maps are sorted, one merge pass finds every difference.
+			auto valueIt = aValue.begin();
+			auto previousIt = aPrevious.begin();
+			while (valueIt != aValue.end() || previousIt != aPrevious.end())
+			{
+				if (previousIt == aPrevious.end() || (valueIt != aValue.end() && valueIt->first < previousIt->first))
+				{
+					changedEntries.insert(changedEntries.end(), *valueIt++);
+				}
+				else if (valueIt == aValue.end() || previousIt->first < valueIt->first)
+				{
+					erasedKeys.push_back((previousIt++)->first);
+				}
+				else
+				{
+					if (!(valueIt->second == previousIt->second))
+					{
+						changedEntries.insert(changedEntries.end(), *valueIt);
+					}
+
+					++valueIt;
+					++previousIt;
+				}
+			}
+		}
+		else
+		{
+			for (auto& entry : aPrevious)
+			{
+				if (aValue.find(entry.first) == aValue.end())
+				{
+					erasedKeys.push_back(entry.first);
+				}
+			}
+
+			for (auto& entry : aValue)
+			{
+				auto previousIt = aPrevious.find(entry.first);
+				if (previousIt == aPrevious.end() || !(previousIt->second == entry.second))
+				{
+					changedEntries.insert(entry);
+				}
+			}
+		}
+
+		if (erasedKeys.empty() && changedEntries.empty())
+		{
+			return;
+		}
+
+		if (changedEntries.size() == aValue.size())
+		{
+			aWriter.beginEntry(CSTypeDefines::DeltaOperation::Replace);
+			aWriter.appendValue(aValue);
+			return;
+		}
+
+		if (!erasedKeys.empty())
+		{
+			aWriter.beginEntry(CSTypeDefines::DeltaOperation::Remove);
+			aWriter.appendValue(erasedKeys);
+		}
+
+		if (!changedEntries.empty())
+		{
+			aWriter.beginEntry(CSTypeDefines::DeltaOperation::Insert);
+			aWriter.appendValue(changedEntries);
+		}
+	}
+
+	static void apply(DeltaReader& aReader, CSTypeDefines::DeltaOperation aOperation, MapType& aValue)
+	{
+		if (aOperation == CSTypeDefines::DeltaOperation::Insert)
+		{
+			// Moves the decoded nodes over, replacing entries with the same key.
+			MapType changedEntries(aValue.get_allocator());
+			aReader.readValueInto(changedEntries);
+			while (!changedEntries.empty())
+			{
+				auto node = changedEntries.extract(changedEntries.begin());
+				aValue.erase(node.key());
+				aValue.insert(std::move(node));
+			}
+		}
+		else if (aOperation == CSTypeDefines::DeltaOperation::Remove)
+		{
+			for (auto& key : aReader.readValue<std::vector<KeyType>>())
+			{
+				aValue.erase(key);
+			}
+		}
+		else
+		{
+			aReader.readValueInto(aValue);
+		}
+	}
+};
+
+// @ MAP DELTA @
+
+#endif // !__CS_VALUE_DELTA_H__
@@ -1,6 +1,8 @@
 #include "csconverter/CSConvertableStruct.h"
+#include "csconverter/CSConvertableFields.h"
 #include <iostream>
 #include <set>
+#include <algorithm>
 
 struct StructTest : public ConvertableStruct
 {
@@ -18,6 +20,16 @@ struct StructTest : public ConvertableStruct
 	}
 };
 
+struct StaticStructTest
+{
+	int value;
+	std::string type;
+	std::map<std::string, int> testMap;
+	std::vector<std::string> testVector;
+};
+
+CS_CONVERTABLE_FIELDS(StaticStructTest, CS_FIELD(value), CS_FIELD(type), CS_FIELD(testMap), CS_FIELD(testVector))
+
 int main()
 {
 	std::cout << "-- Converting object to line Info --" << "\n\n";
@@ -39,12 +51,22 @@ int main()
 
 	std::cout << "-- Updating object --" << "\n\n";
 
+	StructTest previousTest = test;
+
 	test.value = 20;
 	test.type = "cat";
 	test.testVector.push_back("new_ar_test");
 	test.testMap.emplace("test10", 800);
 
 	std::cout << test.convertObjectToLineSave() << "\n\n";
+
+	std::cout << "-- Sending only the update --" << "\n\n";
+
+	std::string delta = test.convertObjectToDelta(previousTest);
+	std::cout << delta << "\n";
+
+	previousTest.applyDelta(delta);
+	std::cout << previousTest.convertObjectToLineSave() << "\n\n";
 	
 	std::cout << "-- Converting line to Object Info --" << "\n\n";
 
@@ -70,4 +92,21 @@ int main()
 	}
 
 	std::cout << "\n";
+
+	std::cout << "-- Storing objects by value --" << "\n\n";
+
+	std::vector<StructTest> tests{ test, convertToObj };
+	tests.push_back(std::move(test));
+	std::sort(tests.begin(), tests.end(), [](const StructTest& aLeft, const StructTest& aRight) { return aLeft.value < aRight.value; });
+
+	for (auto& storedTest : tests)
+	{
+		std::cout << storedTest.convertObjectToLineSave() << "\n";
+	}
+
+	std::cout << "\n";
+	std::cout << "-- Converting static struct to line Info --" << "\n\n";
+
+	StaticStructTest staticTest{ convertToObj.value, convertToObj.type, convertToObj.testMap, convertToObj.testVector };
+	std::cout << StaticConvertableStruct<StaticStructTest>::convertObjectToLineSave(staticTest) << "\n";
 }
\ No newline at end of file
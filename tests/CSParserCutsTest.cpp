@@ -0,0 +1,96 @@
+#include "csconverter/CSConvertableStruct.h"
+#include "csconverter/CSLineSaveParser.h"
+
+#include <iostream>
+
+// Feeds an input cut in two at every byte offset, and one byte at a time,
+// through LineSaveParser and checks the records match feeding it whole. The
+// input mixes counted, uncounted, "\r\n" and failing lines.
+//
+//	csparser_cuts_test
+//
+// Exits with 1 on the first mismatch.
+
+struct CutsStruct : public ConvertableStruct
+{
+	int value = 10;
+	std::string type = "work";
+	std::map<std::string, int> testMap = { { "test1", 200 }, { "test2", 300 }, { "test6", 500 }, { "test7", 800 } };
+	std::vector<std::string> testVector = { "ar_test", "ar_test2", "ar_tes3", "ar_tes4" };
+
+	CutsStruct()
+	{
+		pushValue("value", &value);
+		pushValue("type", &type);
+		pushValue("testMap", &testMap);
+		pushValue("testVector", &testVector);
+	}
+};
+
+std::vector<std::string> decode(const std::vector<std::string_view>& aChunks)
+{
+	CutsStruct record;
+	LineSaveParser parser(record);
+	std::vector<std::string> records;
+	auto collect = [&records](ConvertableStruct& aRecord) { records.push_back(aRecord.convertObjectToLineSave()); };
+
+	for (auto chunk : aChunks)
+	{
+		try
+		{
+			parser.feed(chunk, collect);
+		}
+		catch (const std::exception&)
+		{
+			// The failing records are left out, the rest has to match.
+		}
+	}
+
+	parser.finish(collect);
+	return records;
+}
+
+int main()
+{
+	CutsStruct record;
+	std::string input = record.convertObjectToLineSave() + "\n";
+	input += "m$s^i$test1^200#test2^300|v$s$ar_test^ar_test2|s$cat|i$20\n";
+	record.value = 30;
+	input += record.convertObjectToLineSave() + "\r\n\n";
+	input += "m$s^i$test1^oops|v$s$a|s$dog|i$40\n";
+	input += "m$s^i$1$a^1|v$s$16777216$a^b|s$dog|i$50\n";
+	record.value = 60;
+	input += record.convertObjectToLineSave() + "\n";
+
+	std::string_view data = input;
+	auto expected = decode({ data });
+	if (expected.size() != 4)
+	{
+		std::cout << "Whole input decoded " << expected.size() << " records, expected 4\n";
+		return 1;
+	}
+
+	for (std::size_t offset = 0; offset <= data.size(); ++offset)
+	{
+		if (decode({ data.substr(0, offset), data.substr(offset) }) != expected)
+		{
+			std::cout << "Mismatch with the input cut at byte " << offset << "\n";
+			return 1;
+		}
+	}
+
+	std::vector<std::string_view> bytes;
+	for (std::size_t offset = 0; offset < data.size(); ++offset)
+	{
+		bytes.push_back(data.substr(offset, 1));
+	}
+
+	if (decode(bytes) != expected)
+	{
+		std::cout << "Mismatch with the input fed byte by byte\n";
+		return 1;
+	}
+
+	std::cout << data.size() + 2 << " ways to cut " << expected.size() << " records: all decode alike\n";
+	return 0;
+}